@@ -0,0 +1,265 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+std::atomic<size_t> num_allocations { 0 };
+
+void* allocate(size_t size)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    // malloc(0) may return nullptr, but new must return a unique pointer
+    if (auto ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocate_aligned(size_t size, std::align_val_t align)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto alignment = std::max(static_cast<size_t>(align), sizeof(void*));
+    // aligned_alloc requires size to be a multiple of the alignment
+    const auto padded = (std::max(size, size_t(1)) + alignment - 1) / alignment * alignment;
+#if defined(_MSC_VER)
+    if (auto ptr = _aligned_malloc(padded, alignment)) {
+#else
+    if (auto ptr = std::aligned_alloc(alignment, padded)) {
+#endif
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void free_aligned(void* ptr)
+{
+#if defined(_MSC_VER)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+}
+
+// The nothrow and array versions call these by default
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t align)
+{
+    return allocate_aligned(size, align);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    free_aligned(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    free_aligned(ptr);
+}
+
+namespace pasta::bench {
+
+namespace {
+#if defined(__linux__)
+    struct EventConfig {
+        uint32_t type;
+        uint64_t config;
+    };
+
+    constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result)
+    {
+        return cache | (op << 8) | (result << 16);
+    }
+
+    constexpr std::array<EventConfig, NumCounters> event_configs {
+        EventConfig { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        EventConfig { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        EventConfig { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        EventConfig { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        EventConfig { PERF_TYPE_HW_CACHE,
+            cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS) },
+    };
+
+    int open_event(const EventConfig& event)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // Needed to scale the counts if there are more events than hardware counters
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    bool counters_disabled()
+    {
+        const auto env = std::getenv("PASTA_BENCH_NO_COUNTERS");
+        return env && std::strcmp(env, "0") != 0;
+    }
+}
+
+PerfCounters::PerfCounters()
+{
+    fds_.fill(-1);
+#if defined(__linux__)
+    if (counters_disabled()) {
+        return;
+    }
+    for (size_t c = 0; c < NumCounters; ++c) {
+        fds_[c] = open_event(event_configs[c]);
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+    for (const auto fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::available() const
+{
+    for (const auto fd : fds_) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start()
+{
+#if defined(__linux__)
+    for (const auto fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+CounterValues PerfCounters::stop()
+{
+    CounterValues values;
+#if defined(__linux__)
+    for (const auto fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t c = 0; c < NumCounters; ++c) {
+        if (fds_[c] < 0) {
+            continue;
+        }
+        uint64_t data[3] = {}; // value, time enabled, time running
+        if (read(fds_[c], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+            continue;
+        }
+        const auto scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        values[c] = static_cast<uint64_t>(static_cast<double>(data[0]) * scale);
+    }
+#endif
+    return values;
+}
+
+size_t peak_rss()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+size_t allocation_count()
+{
+    return num_allocations.load(std::memory_order_relaxed);
+}
+
+PerfCounters& perf_counters()
+{
+    static PerfCounters counters;
+    return counters;
+}
+
+void print_header()
+{
+    if (!perf_counters().available()) {
+        std::printf("# Hardware performance counters not available\n");
+    }
+    std::printf("%-48s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n", "benchmark", "ns/op",
+        "MB/s", "allocs/op", "cycles", "instrs", "cache-miss", "br-miss", "dtlb-miss", "peak MiB");
+}
+
+void print(const Result& result)
+{
+    std::printf("%-48s %10.2f", result.name.c_str(), result.ns_per_op);
+    if (result.bytes_per_second) {
+        std::printf(" %10.1f", *result.bytes_per_second / 1e6);
+    } else {
+        std::printf(" %10s", "");
+    }
+    std::printf(" %10.2f", result.allocs_per_op);
+    for (const auto& value : result.per_op) {
+        if (value) {
+            std::printf(" %10.2f", *value);
+        } else {
+            std::printf(" %10s", "");
+        }
+    }
+    std::printf(" %10.1f\n", static_cast<double>(result.peak_rss) / (1024.0 * 1024.0));
+    std::fflush(stdout);
+}
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/* Benchmark harness
+
+A minimal harness for the benchmark executables in this directory:
+
+    bench::print_header();
+    bench::run("SlotMap insert", n, [&] { ... n inserts ... });
+
+Every benchmark is executed a number of times and the fastest repetition is reported as time per
+operation, throughput (if the number of bytes processed is passed) and heap allocations per
+operation (counted by replacing the global operator new in every benchmark linking this).
+On Linux it also reports cycles, instructions, cache misses, branch misses and dTLB misses per
+operation from hardware performance counters (perf_event_open). If a counter is not
+available (not Linux, no PMU in a VM, perf_event_paranoid too high), its column is just empty.
+Set PASTA_BENCH_NO_COUNTERS=1 to not use them at all.
+The last column is the peak resident set size of the whole process so far, so run the benchmarks
+with the largest expected memory usage last or in a separate process if it matters.
+*/
+
+namespace pasta::bench {
+
+enum class Counter { Cycles = 0, Instructions, CacheMisses, BranchMisses, DtlbMisses, Count };
+
+constexpr size_t NumCounters = static_cast<size_t>(Counter::Count);
+
+using CounterValues = std::array<std::optional<uint64_t>, NumCounters>;
+
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // True if at least one counter could be opened
+    bool available() const;
+
+    void start();
+    // Returns the counts since start() (scaled if the kernel had to multiplex the counters)
+    CounterValues stop();
+
+private:
+    std::array<int, NumCounters> fds_;
+};
+
+// The work done by one call of the benchmarked function
+struct Work {
+    Work(size_t num_ops, size_t num_bytes = 0) : num_ops(num_ops), num_bytes(num_bytes) { }
+
+    size_t num_ops;
+    size_t num_bytes; // 0 if throughput doesn't make sense
+};
+
+struct Result {
+    std::string name;
+    Work work;
+    double ns_per_op;
+    std::optional<double> bytes_per_second;
+    double allocs_per_op;
+    std::array<std::optional<double>, NumCounters> per_op;
+    size_t peak_rss; // bytes
+};
+
+// Returns 0 if unavailable
+size_t peak_rss();
+
+// Number of calls to operator new so far (in all threads)
+size_t allocation_count();
+
+// A process-wide instance, so the counters are only opened once
+PerfCounters& perf_counters();
+
+void print_header();
+void print(const Result& result);
+
+// Makes the compiler assume value is used, so the computation producing it is not optimized away
+template <typename T>
+void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Calls func() (which should perform work.num_ops operations) repetitions times, prints the fastest
+// run and returns it. setup() is called before every repetition and is not measured.
+template <std::invocable Setup, std::invocable Func>
+Result run(std::string_view name, Work work, Setup&& setup, Func&& func, size_t repetitions = 5)
+{
+    auto& counters = perf_counters();
+    const auto num_ops = static_cast<double>(work.num_ops);
+    Result best { std::string(name), work, 0.0, std::nullopt, 0.0, {}, 0 };
+    for (size_t r = 0; r < repetitions; ++r) {
+        setup();
+        const auto allocs_before = allocation_count();
+        const auto start = std::chrono::steady_clock::now();
+        counters.start();
+        func();
+        const auto values = counters.stop();
+        const auto end = std::chrono::steady_clock::now();
+        const auto allocs = allocation_count() - allocs_before;
+        const auto ns = std::chrono::duration<double, std::nano>(end - start).count();
+        if (r == 0 || ns / num_ops < best.ns_per_op) {
+            best.ns_per_op = ns / num_ops;
+            if (work.num_bytes > 0) {
+                best.bytes_per_second = static_cast<double>(work.num_bytes) / ns * 1e9;
+            }
+            best.allocs_per_op = static_cast<double>(allocs) / num_ops;
+            for (size_t c = 0; c < NumCounters; ++c) {
+                best.per_op[c] = values[c]
+                    ? std::optional(static_cast<double>(*values[c]) / num_ops)
+                    : std::nullopt;
+            }
+        }
+    }
+    best.peak_rss = peak_rss();
+    print(best);
+    return best;
+}
+
+template <std::invocable Func>
+Result run(std::string_view name, Work work, Func&& func, size_t repetitions = 5)
+{
+    return run(name, work, [] { }, std::forward<Func>(func), repetitions);
+}
+
+}
@@ -0,0 +1,290 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cppasta/fd.hpp>
+#include <cppasta/io.hpp>
+
+#include "bench.hpp"
+
+using namespace pasta;
+namespace fs = std::filesystem;
+
+namespace {
+// Not an assert, so failures are caught in release builds (which is what benchmarks run in)
+void check(bool ok, const char* what)
+{
+    if (!ok) {
+        std::perror(what);
+        std::abort();
+    }
+}
+
+void write_full(int fd, const void* data, size_t size)
+{
+    auto ptr = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const auto n = ::write(fd, ptr, size);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        check(n > 0, "write");
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+void read_full(int fd, void* data, size_t size)
+{
+    auto ptr = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        const auto n = ::read(fd, ptr, size);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0) {
+            std::fprintf(stderr, "read: Unexpected end of file\n");
+            std::abort();
+        }
+        check(n > 0, "read");
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+std::string size_str(size_t size)
+{
+    if (size >= 1024 * 1024 * 1024) {
+        return std::to_string(size / (1024 * 1024 * 1024)) + " GiB";
+    } else if (size >= 1024 * 1024) {
+        return std::to_string(size / (1024 * 1024)) + " MiB";
+    } else if (size >= 1024) {
+        return std::to_string(size / 1024) + " KiB";
+    }
+    return std::to_string(size) + " B";
+}
+
+fs::path create_file(size_t size)
+{
+    const auto path = fs::temp_directory_path() / ("cppasta_bench_io_" + std::to_string(size));
+    Fd fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    check(fd != -1, "open");
+    std::vector<uint8_t> chunk(std::min(size, size_t(1) << 20));
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<uint8_t>(i * 31 + i / 4096);
+    }
+    for (size_t written = 0; written < size; written += chunk.size()) {
+        write_full(fd, chunk.data(), std::min(chunk.size(), size - written));
+    }
+    // Dirty pages can't be dropped from the page cache
+    ::fsync(fd);
+    return path;
+}
+
+// Best effort, the kernel is free to ignore this (e.g. for pages mapped by another process)
+void drop_from_page_cache(const fs::path& path)
+{
+    Fd fd(::open(path.c_str(), O_RDONLY));
+#if defined(POSIX_FADV_DONTNEED)
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+// The baseline: a single copy from the page cache into a buffer of the right size
+std::string read_syscall(const fs::path& path)
+{
+    Fd fd(::open(path.c_str(), O_RDONLY));
+    check(fd != -1, "open");
+    struct stat st;
+    check(::fstat(fd, &st) == 0, "fstat");
+    std::string data(static_cast<size_t>(st.st_size), '\0');
+    read_full(fd, data.data(), data.size());
+    return data;
+}
+
+// No copy at all, but the pages have to be touched to be comparable
+uint64_t read_mmap(const fs::path& path)
+{
+    Fd fd(::open(path.c_str(), O_RDONLY));
+    check(fd != -1, "open");
+    struct stat st;
+    check(::fstat(fd, &st) == 0, "fstat");
+    const auto size = static_cast<size_t>(st.st_size);
+    const auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    check(ptr != MAP_FAILED, "mmap");
+    const auto data = static_cast<const uint8_t*>(ptr);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += 4096) {
+        sum += data[i];
+    }
+    ::munmap(ptr, size);
+    return sum;
+}
+
+void bench_read_file(size_t size)
+{
+    const auto path = create_file(size);
+    const auto name = size_str(size);
+
+    const std::vector<std::pair<std::string, std::function<void()>>> strategies {
+        { "readFileStr", [&] { bench::do_not_optimize(readFileStr(path)); } },
+        { "readFileBin", [&] { bench::do_not_optimize(readFileBin(path)); } },
+        { "read", [&] { bench::do_not_optimize(read_syscall(path)); } },
+        { "mmap", [&] { bench::do_not_optimize(read_mmap(path)); } },
+    };
+
+    // Read ~256 MiB per repetition for small files, so the time is measurable
+    const auto reads = std::max(size_t(1), (size_t(256) << 20) / size);
+    for (const auto& [strategy, read] : strategies) {
+        read();
+        bench::run(strategy + " " + name + " (hot)", { reads, reads * size }, [&] {
+            for (size_t i = 0; i < reads; ++i) {
+                read();
+            }
+        });
+    }
+    for (const auto& [strategy, read] : strategies) {
+        bench::run(
+            strategy + " " + name + " (cold)", { 1, size }, [&] { drop_from_page_cache(path); },
+            read);
+    }
+    fs::remove(path);
+}
+
+// Runs func on the other end of the pipes, either in a thread or in a forked process
+class Peer {
+public:
+    Peer(bool process, std::function<void()> func)
+    {
+        if (process) {
+            pid_ = ::fork();
+            check(pid_ != -1, "fork");
+            if (pid_ == 0) {
+                func();
+                ::_exit(0);
+            }
+        } else {
+            thread_ = std::thread(std::move(func));
+        }
+    }
+
+    Peer(const Peer&) = delete;
+    Peer& operator=(const Peer&) = delete;
+
+    ~Peer() { join(); }
+
+    void join()
+    {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (pid_ > 0) {
+            ::waitpid(pid_, nullptr, 0);
+            pid_ = -1;
+        }
+    }
+
+private:
+    std::thread thread_;
+    pid_t pid_ = -1;
+};
+
+void bench_pipe_throughput(bool process, size_t message_size)
+{
+    const auto name = std::string("Pipe throughput ") + (process ? "(process) " : "(thread) ")
+        + size_str(message_size);
+    const auto num_messages = std::max(size_t(1), (size_t(256) << 20) / message_size);
+    std::optional<Pipe> data, ack;
+    std::optional<Peer> peer;
+    std::vector<uint8_t> send_buf(message_size, 42);
+
+    bench::run(
+        name, { num_messages, num_messages * message_size },
+        [&] {
+            peer.reset();
+            data.emplace();
+            ack.emplace();
+            peer.emplace(process, [&] {
+                std::vector<uint8_t> recv_buf(message_size);
+                for (size_t i = 0; i < num_messages; ++i) {
+                    read_full(data->read, recv_buf.data(), message_size);
+                }
+                const uint8_t done = 1;
+                write_full(ack->write, &done, 1);
+            });
+        },
+        [&] {
+            for (size_t i = 0; i < num_messages; ++i) {
+                write_full(data->write, send_buf.data(), message_size);
+            }
+            uint8_t done = 0;
+            read_full(ack->read, &done, 1);
+        });
+    peer.reset();
+}
+
+void bench_pipe_latency(bool process, size_t message_size)
+{
+    const auto name = std::string("Pipe round trip ") + (process ? "(process) " : "(thread) ")
+        + size_str(message_size);
+    constexpr size_t num_round_trips = 20'000;
+    std::optional<Pipe> ping, pong;
+    std::optional<Peer> peer;
+    std::vector<uint8_t> buf(message_size, 42);
+
+    bench::run(
+        name, { num_round_trips, 2 * num_round_trips * message_size },
+        [&] {
+            peer.reset();
+            ping.emplace();
+            pong.emplace();
+            peer.emplace(process, [&] {
+                std::vector<uint8_t> echo_buf(message_size);
+                for (size_t i = 0; i < num_round_trips; ++i) {
+                    read_full(ping->read, echo_buf.data(), message_size);
+                    write_full(pong->write, echo_buf.data(), message_size);
+                }
+            });
+        },
+        [&] {
+            for (size_t i = 0; i < num_round_trips; ++i) {
+                write_full(ping->write, buf.data(), message_size);
+                read_full(pong->read, buf.data(), message_size);
+            }
+        });
+    peer.reset();
+}
+}
+
+// Usage: bench_io [max file size in bytes, default 256 MiB]
+int main(int argc, char** argv)
+{
+    const size_t max_size = argc > 1 ? std::stoull(argv[1]) : size_t(256) << 20;
+    bench::print_header();
+
+    for (size_t size = 4096; size <= max_size; size *= 16) {
+        bench_read_file(size);
+    }
+
+    for (const bool process : { false, true }) {
+        for (const size_t message_size : { 64, 4096, 65536, 1 << 20 }) {
+            bench_pipe_throughput(process, message_size);
+        }
+        for (const size_t message_size : { 1, 64, 4096 }) {
+            bench_pipe_latency(process, message_size);
+        }
+    }
+}
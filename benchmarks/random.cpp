@@ -0,0 +1,238 @@
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cppasta/random.hpp>
+#include <cppasta/views.hpp>
+
+#include "bench.hpp"
+
+using namespace pasta;
+
+/* RNG benchmark
+
+Measures the throughput of the functions in random.hpp (using getRng(), so whatever
+CPPASTA_RNG_ENGINE is) and of the raw standard engines for comparison.
+With --check it also runs a few statistical smoke tests on getRng() and the standard engines:
+chi-square tests for uniformity of random<int>(0, 255), random<float>() and shuffle (of 4
+elements) and the lag-1 serial correlation of random<float>(). These only catch gross errors
+(like a broken distribution or a bad engine), they are no replacement for TestU01 or PractRand.
+*/
+
+namespace {
+template <typename Engine>
+void bench_engine(const char* name)
+{
+    Engine engine(42);
+    constexpr size_t n = 10'000'000;
+    bench::run(std::string("engine ") + name, n, [&] {
+        typename Engine::result_type acc = 0;
+        for (size_t i = 0; i < n; ++i) {
+            acc ^= engine();
+        }
+        bench::do_not_optimize(acc);
+    });
+}
+
+void bench_functions()
+{
+    constexpr size_t n = 10'000'000;
+    bench::run("random<int>(0, 99)", n, [&] {
+        int acc = 0;
+        for (size_t i = 0; i < n; ++i) {
+            acc += random<int>(0, 99);
+        }
+        bench::do_not_optimize(acc);
+    });
+    bench::run("random<uint64_t>(0, 2^48)", n, [&] {
+        uint64_t acc = 0;
+        for (size_t i = 0; i < n; ++i) {
+            acc += random<uint64_t>(0, 1ull << 48);
+        }
+        bench::do_not_optimize(acc);
+    });
+    bench::run("random<float>()", n, [&] {
+        float acc = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            acc += random<float>();
+        }
+        bench::do_not_optimize(acc);
+    });
+    bench::run("random<float>(-1, 1)", n, [&] {
+        float acc = 0.0f;
+        for (size_t i = 0; i < n; ++i) {
+            acc += random<float>(-1.0f, 1.0f);
+        }
+        bench::do_not_optimize(acc);
+    });
+    bench::run("random<bool>()", n, [&] {
+        size_t acc = 0;
+        for (size_t i = 0; i < n; ++i) {
+            acc += random<bool>();
+        }
+        bench::do_not_optimize(acc);
+    });
+
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 0);
+    bench::run("random(container)", n, [&] {
+        int acc = 0;
+        for (size_t i = 0; i < n; ++i) {
+            acc += random(values);
+        }
+        bench::do_not_optimize(acc);
+    });
+
+    for (const size_t size : { 1000, 1'000'000 }) {
+        std::vector<int> vec(size);
+        std::iota(vec.begin(), vec.end(), 0);
+        const auto reps = n / size;
+        bench::run("shuffle " + std::to_string(size), { reps * size, reps * size * sizeof(int) },
+            [&] {
+                for (size_t r = 0; r < reps; ++r) {
+                    shuffle(vec);
+                }
+                bench::do_not_optimize(vec.data());
+            });
+        bench::run("RandomView " + std::to_string(size) + " (create + iterate)", reps * size, [&] {
+            int acc = 0;
+            for (size_t r = 0; r < reps; ++r) {
+                for (const auto v : RandomView(vec)) {
+                    acc += v;
+                }
+            }
+            bench::do_not_optimize(acc);
+        });
+    }
+}
+
+// Wilson-Hilferty approximation, good enough for the large degrees of freedom used here
+double chi_square_z(double chi2, double df)
+{
+    const auto v = 2.0 / (9.0 * df);
+    return (std::cbrt(chi2 / df) - (1.0 - v)) / std::sqrt(v);
+}
+
+double chi_square(const std::vector<size_t>& counts, size_t n)
+{
+    const auto expected = static_cast<double>(n) / static_cast<double>(counts.size());
+    double chi2 = 0.0;
+    for (const auto count : counts) {
+        const auto d = static_cast<double>(count) - expected;
+        chi2 += d * d / expected;
+    }
+    return chi2;
+}
+
+bool report(std::string_view engine, std::string_view test, double z)
+{
+    // Two-sided p < 0.001 in either direction (too uniform is suspicious too)
+    const auto pass = std::abs(z) < 3.29;
+    std::printf("%-20s %-32s z = %8.3f  %s\n", engine.data(), test.data(), z,
+        pass ? "ok" : "FAIL");
+    return pass;
+}
+
+// int_gen() returns ints in [0, 255], float_gen() floats in [0, 1), shuffle_func shuffles a vector
+template <typename IntGen, typename FloatGen, typename ShuffleFunc>
+bool check(std::string_view engine, IntGen&& int_gen, FloatGen&& float_gen,
+    ShuffleFunc&& shuffle_func)
+{
+    constexpr size_t n = 10'000'000;
+    bool pass = true;
+
+    std::vector<size_t> counts(256);
+    for (size_t i = 0; i < n; ++i) {
+        counts[static_cast<size_t>(int_gen())]++;
+    }
+    pass &= report(engine, "chi-square int [0, 255]", chi_square_z(chi_square(counts, n), 255));
+
+    std::fill(counts.begin(), counts.end(), 0);
+    std::vector<double> floats(n);
+    for (size_t i = 0; i < n; ++i) {
+        floats[i] = float_gen();
+        counts[std::min(static_cast<size_t>(floats[i] * 256.0), size_t(255))]++;
+    }
+    pass &= report(engine, "chi-square float [0, 1)", chi_square_z(chi_square(counts, n), 255));
+
+    // Lag-1 serial correlation, approximately N(0, 1/n) for independent values
+    double mean = 0.0;
+    for (const auto f : floats) {
+        mean += f;
+    }
+    mean /= static_cast<double>(n);
+    double num = 0.0, denom = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const auto d = floats[i] - mean;
+        num += d * (floats[(i + 1) % n] - mean);
+        denom += d * d;
+    }
+    const auto r = num / denom;
+    pass &= report(engine, "serial correlation", r * std::sqrt(static_cast<double>(n)));
+
+    // All 24 permutations of 4 elements should be equally likely
+    constexpr size_t shuffles = 2'400'000;
+    std::vector<size_t> perm_counts(24);
+    std::vector<int> perm(4);
+    for (size_t i = 0; i < shuffles; ++i) {
+        std::iota(perm.begin(), perm.end(), 0);
+        shuffle_func(perm);
+        // Lehmer code
+        size_t code = 0;
+        for (size_t j = 0; j < 4; ++j) {
+            size_t smaller = 0;
+            for (size_t k = j + 1; k < 4; ++k) {
+                smaller += perm[k] < perm[j];
+            }
+            code = code * (4 - j) + smaller;
+        }
+        perm_counts[code]++;
+    }
+    pass &= report(engine, "chi-square shuffle (4! perms)",
+        chi_square_z(chi_square(perm_counts, shuffles), 23));
+    return pass;
+}
+
+template <typename Engine>
+bool check_engine(const char* name)
+{
+    Engine engine(42);
+    std::uniform_int_distribution<int> int_dist(0, 255);
+    std::uniform_real_distribution<double> float_dist(0.0, 1.0);
+    return check(
+        name, [&] { return int_dist(engine); }, [&] { return float_dist(engine); },
+        [&](std::vector<int>& v) { std::shuffle(v.begin(), v.end(), engine); });
+}
+}
+
+// Usage: bench_random [--check]
+int main(int argc, char** argv)
+{
+    const auto run_checks = argc > 1 && std::string_view(argv[1]) == "--check";
+
+    bench::print_header();
+    bench_functions();
+    bench_engine<std::minstd_rand>("minstd_rand");
+    bench_engine<std::mt19937>("mt19937");
+    bench_engine<std::mt19937_64>("mt19937_64");
+    bench_engine<std::ranlux24>("ranlux24");
+    bench_engine<std::default_random_engine>("default_random_engine");
+
+    if (!run_checks) {
+        return 0;
+    }
+    std::printf("\n");
+    bool pass = check(
+        "getRng()", [] { return random<int>(0, 255); }, [] { return random<float>(); },
+        [](std::vector<int>& v) { shuffle(v); });
+    pass &= check_engine<std::minstd_rand>("minstd_rand");
+    pass &= check_engine<std::mt19937>("mt19937");
+    pass &= check_engine<std::mt19937_64>("mt19937_64");
+    pass &= check_engine<std::ranlux24>("ranlux24");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cppasta/dense_slot_map.hpp>
+#include <cppasta/incremental_vector.hpp>
+#include <cppasta/slot_map.hpp>
+
+#include "bench.hpp"
+
+using namespace pasta;
+
+struct Particle {
+    float position[3];
+    float velocity[3];
+    float lifetime;
+    uint32_t color;
+};
+
+template <typename T, typename Key>
+using GrowableStorage = GrowableSlotMapStorage<T, Key, std::vector<uint32_t>, std::allocator>;
+
+template <typename T, typename Key>
+using PagedStorage = PagedSlotMapStorage<T, Key, std::vector<uint32_t>, std::allocator>;
+
+template <typename T, typename Key>
+using NarrowStorage = GrowableSlotMapStorage<T, Key, std::vector<uint8_t>, std::allocator>;
+
+template <typename T, typename Key>
+using PackedStorage = GrowableSlotMapStorage<T, Key, PackedGenerations<6>, std::allocator>;
+
+template <typename T, typename Key>
+using IncrementalStorage = IncrementalSlotMapStorage<T, Key, std::allocator>;
+
+template <typename Map>
+void bench_slot_map(const std::string& name, size_t n)
+{
+    using Key = typename Map::Key;
+    std::optional<Map> map;
+    std::vector<Key> keys;
+    std::mt19937 rng(42);
+
+    const auto fill = [&] {
+        map.reset();
+        map.emplace(n);
+        keys.clear();
+        for (size_t i = 0; i < n; ++i) {
+            keys.push_back(map->insert(Particle { {}, {}, static_cast<float>(i), 0 }));
+        }
+    };
+
+    bench::run(
+        name + " insert", n,
+        [&] {
+            map.reset();
+            map.emplace(n);
+        },
+        [&] {
+            for (size_t i = 0; i < n; ++i) {
+                bench::do_not_optimize(map->insert(Particle { {}, {}, static_cast<float>(i), 0 }));
+            }
+        });
+
+    fill();
+    auto shuffled_keys = keys;
+    std::shuffle(shuffled_keys.begin(), shuffled_keys.end(), rng);
+    // Only resolving the keys, because accessing the elements afterwards costs the same
+    std::vector<Particle*> particles(n);
+    bench::run(name + " get (random order)", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            particles[i] = map->get(shuffled_keys[i]);
+        }
+        bench::do_not_optimize(particles.data());
+    });
+    bench::run(name + " get_many (random order)", n, [&] {
+        map->get_many(shuffled_keys, particles);
+        bench::do_not_optimize(particles.data());
+    });
+    bench::run(name + " find (random order)", n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            particles[i] = map->find(shuffled_keys[i]);
+        }
+        bench::do_not_optimize(particles.data());
+    });
+    bench::run(name + " find_many (random order)", n, [&] {
+        map->find_many(shuffled_keys, particles);
+        bench::do_not_optimize(particles.data());
+    });
+
+    // Remove a random half, so iteration has to skip a lot of small holes
+    const auto remove_half = [&] {
+        fill();
+        std::mt19937 remove_rng(1);
+        for (const auto key : keys) {
+            if (remove_rng() % 2) {
+                map->remove(key);
+            }
+        }
+    };
+    remove_half();
+    bench::run(name + " iterate (50% removed)", map->size(), [&] {
+        float sum = 0.0f;
+        for (auto key = map->next({}); key; key = map->next(key)) {
+            sum += map->get(key)->lifetime;
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    // Remove all but the first and the last element, so there is a single large hole.
+    // Back to front, because IntSkipfield rewrites the whole block when growing it to the right.
+    fill();
+    for (size_t i = n - 2; i > 0; --i) {
+        map->remove(keys[i]);
+    }
+    bench::run(name + " iterate (one large hole)", 1, [&] {
+        size_t count = 0;
+        for (auto key = map->next({}); key; key = map->next(key)) {
+            count++;
+        }
+        bench::do_not_optimize(count);
+    });
+
+    bench::run(name + " remove (random order)", n, fill, [&] {
+        for (const auto key : shuffled_keys) {
+            map->remove(key);
+        }
+    });
+    bench::run(name + " clear", n, fill, [&] { map->clear(); });
+}
+
+// Dereferencing the same few keys over and over again, so everything is in cache
+template <typename Map>
+void bench_cached_handles(const std::string& name, size_t n)
+{
+    Map map(n / 4, n / 4);
+    std::vector<typename Map::Key> keys;
+    for (size_t i = 0; i < n; ++i) {
+        keys.push_back(map.insert(Particle { {}, {}, static_cast<float>(i), 0 }));
+    }
+    std::mt19937 rng(42);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    keys.resize(64);
+    std::vector<decltype(map.cache(keys[0]))> handles;
+    for (const auto key : keys) {
+        handles.push_back(map.cache(key));
+    }
+
+    const auto reps = n / keys.size();
+    bench::run(name + " get (64 hot keys)", reps * keys.size(), [&] {
+        float sum = 0.0f;
+        for (size_t r = 0; r < reps; ++r) {
+            for (const auto key : keys) {
+                sum += map.get(key)->lifetime;
+            }
+        }
+        bench::do_not_optimize(sum);
+    });
+    bench::run(name + " find (64 hot keys)", reps * keys.size(), [&] {
+        float sum = 0.0f;
+        for (size_t r = 0; r < reps; ++r) {
+            for (const auto key : keys) {
+                if (const auto p = map.find(key)) {
+                    sum += p->lifetime;
+                }
+            }
+        }
+        bench::do_not_optimize(sum);
+    });
+    bench::run(name + " CachedHandle (64 hot keys)", reps * keys.size(), [&] {
+        float sum = 0.0f;
+        for (size_t r = 0; r < reps; ++r) {
+            for (const auto& handle : handles) {
+                if (const auto p = handle.get()) {
+                    sum += p->lifetime;
+                }
+            }
+        }
+        bench::do_not_optimize(sum);
+    });
+}
+
+// The harness only reports the mean, but growing is about the worst case, so this times every
+// single insert into a map that starts small and doubles until it contains n elements
+template <typename Map>
+void bench_insert_latency(const std::string& name, size_t n)
+{
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> best_ns;
+    for (size_t r = 0; r < 5; ++r) {
+        Map map(64, 0, 2.0f);
+        std::vector<double> ns(n);
+        for (size_t i = 0; i < n; ++i) {
+            const auto start = Clock::now();
+            map.insert(Particle { {}, {}, static_cast<float>(i), 0 });
+            ns[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        }
+        std::sort(ns.begin(), ns.end());
+        if (best_ns.empty() || ns.back() < best_ns.back()) {
+            best_ns = std::move(ns);
+        }
+    }
+    const auto pct = [&](double p) { return best_ns[static_cast<size_t>(p * (n - 1))]; };
+    std::printf("%-50s p50: %8.0f ns, p99.9: %8.0f ns, max: %10.0f ns\n",
+        (name + " insert latency").c_str(), pct(0.5), pct(0.999), best_ns.back());
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n = argc > 1 ? std::stoull(argv[1]) : 1 << 18;
+    using Key = CompositeId<Particle>;
+    bench::print_header();
+    bench_slot_map<SlotMap<Particle, GrowableStorage>>("Growable", n);
+    bench_slot_map<SlotMap<Particle, GrowableStorage, Key, IntSkipfield<std::vector>>>(
+        "Growable+IntSkipfield", n);
+    bench_slot_map<SlotMap<Particle, GrowableStorage, Key, BoolSkipfield<std::vector>>>(
+        "Growable+BoolSkipfield", n);
+    bench_slot_map<SlotMap<Particle, GrowableStorage, Key, BitSkipfield>>(
+        "Growable+BitSkipfield", n);
+    bench_slot_map<SlotMap<Particle, NarrowStorage>>("Growable (8 bit gens)", n);
+    bench_slot_map<SlotMap<Particle, PackedStorage>>("Growable (6 bit gens)", n);
+    bench_slot_map<SlotMap<Particle, PagedStorage>>("Paged", n);
+    bench_slot_map<SlotMap<Particle, PagedStorage, Key, BitSkipfield>>("Paged+BitSkipfield", n);
+    bench_slot_map<SlotMap<Particle, IncrementalStorage, Key, BitSkipfield>>(
+        "Incremental+BitSkipfield", n);
+    bench_cached_handles<SlotMap<Particle, PagedStorage>>("Paged", n);
+
+    bench_insert_latency<SlotMap<Particle, GrowableStorage>>("Growable", n);
+    bench_insert_latency<SlotMap<Particle, IncrementalStorage>>("Incremental", n);
+    bench_insert_latency<SlotMap<Particle, IncrementalStorage, Key, BitSkipfield>>(
+        "Incremental+BitSkipfield", n);
+    bench_insert_latency<DenseSlotMap<Particle, std::vector, std::vector>>("Dense", n);
+    bench_insert_latency<DenseSlotMap<Particle, IncrementalVector, IncrementalVector>>(
+        "Dense (IncrementalVector)", n);
+}
@@ -0,0 +1,195 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cppasta/strings.hpp>
+
+#include "bench.hpp"
+
+using namespace pasta;
+
+namespace {
+std::mt19937 rng(42);
+
+size_t random_int(size_t min, size_t max)
+{
+    return std::uniform_int_distribution<size_t>(min, max)(rng);
+}
+
+std::string random_word(size_t min_len, size_t max_len)
+{
+    std::string word(random_int(min_len, max_len), ' ');
+    for (auto& c : word) {
+        c = static_cast<char>('a' + random_int(0, 25));
+    }
+    return word;
+}
+
+std::string log_line()
+{
+    static const char* levels[] = { "DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR" };
+    static const char* methods[] = { "GET", "GET", "POST", "PUT", "DELETE" };
+    return "2024-05-01T12:" + std::to_string(random_int(10, 59)) + ":"
+        + std::to_string(random_int(10, 59)) + ".123Z " + levels[random_int(0, 5)] + "  [worker-"
+        + std::to_string(random_int(0, 15)) + "] request_id=" + random_word(16, 16)
+        + " method=" + methods[random_int(0, 4)] + " path=/api/v1/" + random_word(3, 12) + "/"
+        + std::to_string(random_int(0, 100000)) + " status=200 duration_ms="
+        + std::to_string(random_int(0, 500)) + "." + std::to_string(random_int(0, 9));
+}
+
+std::string csv_row(size_t num_columns)
+{
+    std::string row;
+    for (size_t i = 0; i < num_columns; ++i) {
+        if (i > 0) {
+            row += ',';
+        }
+        switch (i % 4) {
+        case 0:
+            row += std::to_string(random_int(0, 1'000'000));
+            break;
+        case 1:
+            row += random_word(3, 10) + " " + random_word(3, 12);
+            break;
+        case 2:
+            row += std::to_string(random_int(0, 1000)) + "." + std::to_string(random_int(0, 999));
+            break;
+        default:
+            // Empty fields are common
+            if (random_int(0, 3) > 0) {
+                row += random_word(0, 8);
+            }
+        }
+    }
+    return row;
+}
+
+std::string http_header()
+{
+    static const char* headers[] = {
+        "Content-Type: application/json; charset=utf-8",
+        "Content-Length: 1234",
+        "Accept-Encoding: gzip, deflate, br",
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:125.0) Gecko/20100101 Firefox/125.0",
+        "Cache-Control: no-cache",
+        "X-Request-ID: 4bf92f3577b34da6a3ce929d0e0e4736",
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8",
+        "Connection: keep-alive",
+    };
+    return headers[random_int(0, std::size(headers) - 1)];
+}
+
+template <typename Func>
+std::vector<std::string> generate(size_t n, Func&& func)
+{
+    std::vector<std::string> strs;
+    for (size_t i = 0; i < n; ++i) {
+        strs.push_back(func());
+    }
+    return strs;
+}
+
+size_t total_size(const std::vector<std::string>& strs)
+{
+    size_t size = 0;
+    for (const auto& str : strs) {
+        size += str.size();
+    }
+    return size;
+}
+
+void bench_split(const std::string& name, const std::vector<std::string>& lines)
+{
+    const bench::Work work { lines.size(), total_size(lines) };
+    bench::run("split (whitespace) " + name, work, [&] {
+        for (const auto& line : lines) {
+            bench::do_not_optimize(split(line));
+        }
+    });
+    bench::run("split (',') " + name, work, [&] {
+        for (const auto& line : lines) {
+            bench::do_not_optimize(split(line, ','));
+        }
+    });
+}
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n = argc > 1 ? std::stoull(argv[1]) : 10'000;
+    bench::print_header();
+
+    const auto log_lines = generate(n, log_line);
+    const auto csv_rows = generate(n, [] { return csv_row(12); });
+    const auto wide_csv_rows = generate(n / 100, [] { return csv_row(400); });
+    const auto headers = generate(n, http_header);
+
+    bench_split("log lines", log_lines);
+    bench_split("CSV rows (12 columns)", csv_rows);
+    bench_split("CSV rows (400 columns)", wide_csv_rows);
+
+    std::vector<std::vector<std::string>> csv_fields;
+    for (const auto& row : csv_rows) {
+        csv_fields.push_back(split(row, ','));
+    }
+    bench::run("join CSV rows (12 columns)", { n, total_size(csv_rows) }, [&] {
+        for (const auto& fields : csv_fields) {
+            bench::do_not_optimize(join(fields, ","));
+        }
+    });
+
+    bench::run("toLower HTTP headers", { n, total_size(headers) }, [&] {
+        for (const auto& header : headers) {
+            bench::do_not_optimize(toLower(header));
+        }
+    });
+    bench::run("startsWith HTTP headers", { n, total_size(headers) }, [&] {
+        size_t count = 0;
+        for (const auto& header : headers) {
+            count += startsWith(header, "Content-");
+        }
+        bench::do_not_optimize(count);
+    });
+    bench::run("endsWith log lines", { n, total_size(log_lines) }, [&] {
+        size_t count = 0;
+        for (const auto& line : log_lines) {
+            count += endsWith(line, ".0");
+        }
+        bench::do_not_optimize(count);
+    });
+
+    for (const size_t size : { 16, 256, 4096 }) {
+        std::vector<uint8_t> data(size);
+        for (auto& b : data) {
+            b = static_cast<uint8_t>(random_int(0, 255));
+        }
+        bench::run("hexString " + std::to_string(size) + " bytes", { 1000, 1000 * size }, [&] {
+            for (size_t i = 0; i < 1000; ++i) {
+                bench::do_not_optimize(hexString(data));
+            }
+        });
+    }
+
+    std::vector<std::string> ints, hex_ints, floats;
+    for (size_t i = 0; i < n; ++i) {
+        const auto value = random_int(0, 1ull << random_int(1, 62));
+        ints.push_back(std::to_string(value));
+        hex_ints.push_back(hexString(&value, random_int(1, 8)));
+        floats.push_back(std::to_string(random_int(0, 100'000)) + "." + std::to_string(value));
+    }
+    bench::run("parseInt (base 10)", { n, total_size(ints) }, [&] {
+        for (const auto& str : ints) {
+            bench::do_not_optimize(parseInt(str));
+        }
+    });
+    bench::run("parseInt<uint64_t> (base 16)", { n, total_size(hex_ints) }, [&] {
+        for (const auto& str : hex_ints) {
+            bench::do_not_optimize(parseInt<uint64_t>(str, 16));
+        }
+    });
+    bench::run("parseFloat", { n, total_size(floats) }, [&] {
+        for (const auto& str : floats) {
+            bench::do_not_optimize(parseFloat(str));
+        }
+    });
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <latch>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cppasta/synchronized.hpp>
+
+#include "bench.hpp"
+
+using namespace pasta;
+
+/* Synchronized contention benchmark
+
+Every thread performs a fixed number of operations, each of which is either a read (lockConst and
+summing the data) or a write (lock and incrementing the data). It reports the total throughput and
+percentiles of the time it took to acquire the lock (which includes two clock reads, ~20-40ns).
+Run it with the maximum number of threads as an argument to get the full scaling curve (the
+default is the number of hardware threads).
+*/
+
+namespace {
+// Test-and-test-and-set spin lock, as an example for an alternative lock policy
+class SpinMutex {
+public:
+    void lock()
+    {
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            while (locked_.load(std::memory_order_relaxed)) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+            }
+        }
+    }
+
+    void unlock() { locked_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> locked_ { false };
+};
+
+struct Data {
+    std::array<uint64_t, 8> values {};
+};
+
+struct Workload {
+    const char* name;
+    uint32_t read_percent;
+};
+
+constexpr std::array workloads {
+    Workload { "read-heavy", 95 },
+    Workload { "mixed", 50 },
+    Workload { "write-heavy", 5 },
+};
+
+double percentile(std::vector<uint32_t>& sorted, double p)
+{
+    const auto idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[idx];
+}
+
+template <typename Mutex>
+void bench_policy(const char* policy, size_t num_threads, const Workload& workload,
+    size_t ops_per_thread)
+{
+    Synchronized<Data, Mutex> data;
+    std::vector<std::vector<uint32_t>> latencies(num_threads);
+    std::latch start(static_cast<std::ptrdiff_t>(num_threads + 1));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            auto& lat = latencies[t];
+            lat.reserve(ops_per_thread);
+            uint64_t rng = 0x9e3779b97f4a7c15ull * (t + 1);
+            start.arrive_and_wait();
+            for (size_t i = 0; i < ops_per_thread; ++i) {
+                // xorshift64
+                rng ^= rng << 13;
+                rng ^= rng >> 7;
+                rng ^= rng << 17;
+                const auto read = rng % 100 < workload.read_percent;
+                const auto before = std::chrono::steady_clock::now();
+                if (read) {
+                    const auto handle = data.lockConst();
+                    const auto after = std::chrono::steady_clock::now();
+                    uint64_t sum = 0;
+                    for (const auto v : handle->values) {
+                        sum += v;
+                    }
+                    bench::do_not_optimize(sum);
+                    lat.push_back(static_cast<uint32_t>((after - before).count()));
+                } else {
+                    auto handle = data.lock();
+                    const auto after = std::chrono::steady_clock::now();
+                    for (auto& v : handle->values) {
+                        v++;
+                    }
+                    lat.push_back(static_cast<uint32_t>((after - before).count()));
+                }
+            }
+        });
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+    start.arrive_and_wait();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin);
+
+    std::vector<uint32_t> all;
+    all.reserve(num_threads * ops_per_thread);
+    for (const auto& lat : latencies) {
+        all.insert(all.end(), lat.begin(), lat.end());
+    }
+    std::sort(all.begin(), all.end());
+    const auto total_ops = static_cast<double>(num_threads * ops_per_thread);
+    std::printf("%-14s %-12s %8zu %12.2f %10.0f %10.0f %10.0f\n", policy, workload.name,
+        num_threads, total_ops / seconds.count() / 1e6, percentile(all, 0.5),
+        percentile(all, 0.99), percentile(all, 0.999));
+    std::fflush(stdout);
+}
+
+template <typename Mutex>
+void bench_policy(const char* policy, size_t max_threads, size_t ops_per_thread)
+{
+    for (const auto& workload : workloads) {
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            bench_policy<Mutex>(policy, threads, workload, ops_per_thread);
+        }
+        // Also the exact maximum if it's not a power of two
+        if ((max_threads & (max_threads - 1)) != 0) {
+            bench_policy<Mutex>(policy, max_threads, workload, ops_per_thread);
+        }
+    }
+}
+}
+
+// Usage: bench_synchronized [max threads] [operations per thread]
+int main(int argc, char** argv)
+{
+    static_assert(std::is_same_v<std::chrono::steady_clock::period, std::nano>);
+    const size_t max_threads = argc > 1
+        ? std::stoull(argv[1])
+        : std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t(1));
+    const size_t ops_per_thread = argc > 2 ? std::stoull(argv[2]) : 100'000;
+
+    std::printf("%-14s %-12s %8s %12s %10s %10s %10s\n", "policy", "workload", "threads",
+        "Mops/s", "p50 ns", "p99 ns", "p999 ns");
+    bench_policy<std::mutex>("std::mutex", max_threads, ops_per_thread);
+    bench_policy<std::shared_mutex>("shared_mutex", max_threads, ops_per_thread);
+    bench_policy<SpinMutex>("spin lock", max_threads, ops_per_thread);
+}
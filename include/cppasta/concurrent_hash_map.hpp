@@ -0,0 +1,559 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "flat_hash_map.hpp"
+#include "prefetch.hpp"
+
+/* ConcurrentHashMap
+
+A hash map that can be used from many threads at once, without a global lock.
+
+The map is split into a power of two number of stripes, which are selected by the high bits of the
+hash. Each stripe is an independent open addressing hash table with its own mutex, which writers
+(insert, erase) have to take. Readers never take a lock.
+
+Each stripe table consists of groups of 8 slots (8 control bytes, 8 keys and 8 values), which are
+probed linearly. Every group has a version counter (a seqlock). A writer increments it before
+modifying the group (making it odd) and after it is done (making it even again). A reader
+remembers the version, copies the slot it is interested in and then checks the version again. If
+it was odd or changed in the meantime, the reader simply retries that group.
+Because readers copy data that might be concurrently written, keys and values have to be trivially
+copyable. They are stored as arrays of relaxed atomic words (as wide as their size allows), so
+these copies are not data races, just possibly torn, and on common platforms relaxed loads and
+stores are plain moves. Lookup returns copies, never references.
+
+When a stripe grows, a new table is built and published atomically. Readers that are still
+probing the old table will finish there (it is not modified anymore after the switch, so they
+observe the state right before the switch). Because we don't know when the last reader has left
+an old table, old tables are retired instead of freed and only freed when the map is destroyed or
+reclaim() is called while nobody else uses the map.
+Tables that are retired because the stripe grew never take more memory than the current table
+(they grow geometrically), but if many tombstones pile up (lots of erases), a stripe is rebuilt at
+the same size, which retires a table of the current size. So if you erase a lot, call reclaim()
+regularly in a quiescent state (e.g. between frames).
+clear() empties the current tables in place, so it doesn't retire anything and keeps the capacity.
+*/
+
+namespace pasta {
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>>
+class ConcurrentHashMap {
+public:
+    static_assert(std::is_trivially_copyable_v<Key>, "Keys are read optimistically");
+    static_assert(std::is_trivially_copyable_v<T>, "Values are read optimistically");
+
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+
+    // num_stripes will be rounded up to a power of two
+    ConcurrentHashMap(size_t num_stripes = 64, size_t capacity = 0, const Hash& hash = {},
+        const KeyEqual& eq = {})
+        : hash_(hash)
+        , eq_(eq)
+    {
+        num_stripes = std::bit_ceil(std::max(num_stripes, size_t(1)));
+        stripe_shift_ = 64 - static_cast<unsigned>(std::countr_zero(num_stripes));
+        stripes_ = std::make_unique<Stripe[]>(num_stripes);
+        num_stripes_ = num_stripes;
+        const auto groups = num_groups_for(capacity / num_stripes_ + 1);
+        for (size_t i = 0; i < num_stripes_; ++i) {
+            stripes_[i].current = std::make_unique<Table>(groups);
+            stripes_[i].table.store(stripes_[i].current.get(), std::memory_order_release);
+        }
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+    /* Readers (lock-free) */
+
+    std::optional<T> find(const Key& key) const
+    {
+        const auto hash = hash_key(key);
+        return find_in(stripe(hash).table.load(std::memory_order_acquire), key, hash);
+    }
+
+    bool contains(const Key& key) const { return find(key).has_value(); }
+
+    // Results are written to out, which must have the same size as keys. This is faster than
+    // calling find in a loop, because the groups of the next few keys are prefetched.
+    void find_many(std::span<const Key> keys, std::span<std::optional<T>> out) const
+    {
+        assert(keys.size() == out.size());
+        uint64_t hashes[PrefetchDistance];
+        const Table* tables[PrefetchDistance];
+        auto prepare = [&](size_t i) {
+            const auto hash = hash_key(keys[i]);
+            const auto table = stripe(hash).table.load(std::memory_order_acquire);
+            hashes[i % PrefetchDistance] = hash;
+            tables[i % PrefetchDistance] = table;
+            prefetch(&table->groups[table->group_index(hash)]);
+        };
+        for (size_t i = 0; i < std::min(PrefetchDistance, keys.size()); ++i) {
+            prepare(i);
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const auto hash = hashes[i % PrefetchDistance];
+            const auto table = tables[i % PrefetchDistance];
+            if (i + PrefetchDistance < keys.size()) {
+                prepare(i + PrefetchDistance);
+            }
+            out[i] = find_in(table, keys[i], hash);
+        }
+    }
+
+    // This is only a snapshot and might be outdated by the time it is returned
+    size_t size() const
+    {
+        size_t s = 0;
+        for (size_t i = 0; i < num_stripes_; ++i) {
+            s += stripes_[i].size.load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /* Writers (lock a single stripe) */
+
+    // Returns false if the key was already present (the value is not changed)
+    bool insert(const Key& key, const T& value)
+    {
+        const auto hash = hash_key(key);
+        auto& s = stripe(hash);
+        std::lock_guard lock(s.mutex);
+        return insert_locked(s, key, value, hash, false);
+    }
+
+    // Returns true if the key was newly inserted
+    bool insert_or_assign(const Key& key, const T& value)
+    {
+        const auto hash = hash_key(key);
+        auto& s = stripe(hash);
+        std::lock_guard lock(s.mutex);
+        return insert_locked(s, key, value, hash, true);
+    }
+
+    // Inserts all elements, taking every stripe lock at most once.
+    // Returns the number of elements that were newly inserted.
+    size_t insert_many(std::span<const value_type> values, bool assign = false)
+    {
+        std::vector<std::pair<uint64_t, size_t>> order(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            order[i] = { hash_key(values[i].first), i };
+        }
+        // Sort by stripe, then by original index, so inserts happen in the order they were passed.
+        std::sort(order.begin(), order.end(), [this](const auto& a, const auto& b) {
+            const auto sa = stripe_index(a.first), sb = stripe_index(b.first);
+            return sa != sb ? sa < sb : a.second < b.second;
+        });
+
+        size_t inserted = 0;
+        size_t i = 0;
+        while (i < order.size()) {
+            auto& s = stripe(order[i].first);
+            std::lock_guard lock(s.mutex);
+            const auto stripe_idx = stripe_index(order[i].first);
+            for (; i < order.size() && stripe_index(order[i].first) == stripe_idx; ++i) {
+                const auto& [key, value] = values[order[i].second];
+                inserted += insert_locked(s, key, value, order[i].first, assign) ? 1 : 0;
+            }
+        }
+        return inserted;
+    }
+
+    bool erase(const Key& key)
+    {
+        const auto hash = hash_key(key);
+        auto& s = stripe(hash);
+        std::lock_guard lock(s.mutex);
+        auto table = s.current.get();
+        const auto [group_idx, slot] = table->find_slot(key, hash, eq_);
+        if (slot == Group::width) {
+            return false;
+        }
+        auto& group = table->groups[group_idx];
+        group.begin_write();
+        // Same reasoning as in flat_hash_map: if there is an empty slot in this group, no probe
+        // sequence ever went past it.
+        group.set_ctrl(slot, group.has_empty() ? CtrlEmpty : CtrlDeleted);
+        group.end_write();
+        s.size.store(s.size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        if (!group.has_empty()) {
+            s.tombstones++;
+        }
+        return true;
+    }
+
+    // Takes all stripe locks (one at a time). Concurrent inserts into stripes that have already
+    // been cleared will be kept. The tables are cleared in place (one group at a time, like any
+    // other write), so concurrent readers are fine and the capacity is kept.
+    void clear()
+    {
+        for (size_t i = 0; i < num_stripes_; ++i) {
+            auto& s = stripes_[i];
+            std::lock_guard lock(s.mutex);
+            auto table = s.current.get();
+            for (size_t g = 0; g < table->num_groups(); ++g) {
+                auto& group = table->groups[g];
+                group.begin_write();
+                group.ctrl.store(0, std::memory_order_relaxed); // All CtrlEmpty
+                group.end_write();
+            }
+            s.size.store(0, std::memory_order_relaxed);
+            s.tombstones = 0;
+        }
+    }
+
+    // Frees the tables that were retired when stripes were rebuilt.
+    // MUST ONLY be called while no other thread uses the map (not even readers), because readers
+    // might still be probing a retired table.
+    void reclaim()
+    {
+        for (size_t i = 0; i < num_stripes_; ++i) {
+            auto& s = stripes_[i];
+            std::lock_guard lock(s.mutex);
+            s.retired.clear();
+        }
+    }
+
+    size_t num_stripes() const { return num_stripes_; }
+
+    // Number of slots in the current tables (a snapshot)
+    size_t capacity() const
+    {
+        size_t c = 0;
+        for (size_t i = 0; i < num_stripes_; ++i) {
+            c += stripes_[i].table.load(std::memory_order_acquire)->capacity();
+        }
+        return c;
+    }
+
+    // Number of slots in the retired tables. This takes all stripe locks.
+    size_t retired_capacity() const
+    {
+        size_t c = 0;
+        for (size_t i = 0; i < num_stripes_; ++i) {
+            auto& s = stripes_[i];
+            std::lock_guard lock(s.mutex);
+            for (const auto& table : s.retired) {
+                c += table->capacity();
+            }
+        }
+        return c;
+    }
+
+private:
+    static constexpr uint8_t CtrlEmpty = 0;
+    static constexpr uint8_t CtrlDeleted = 1;
+    static constexpr uint8_t CtrlFull = 0x80; // | h2
+
+    // Stores the objects as relaxed atomic words, so they can be read while they are written
+    template <typename U, size_t Count>
+    struct SlotArray {
+        using Word = std::conditional_t<sizeof(U) % 8 == 0, uint64_t,
+            std::conditional_t<sizeof(U) % 4 == 0, uint32_t,
+                std::conditional_t<sizeof(U) % 2 == 0, uint16_t, uint8_t>>>;
+        static constexpr size_t num_words = sizeof(U) / sizeof(Word);
+
+        U load(size_t slot) const
+        {
+            Word tmp[num_words];
+            for (size_t i = 0; i < num_words; ++i) {
+                tmp[i] = words[slot * num_words + i].load(std::memory_order_relaxed);
+            }
+            U u;
+            std::memcpy(&u, tmp, sizeof(U));
+            return u;
+        }
+
+        void store(size_t slot, const U& u)
+        {
+            Word tmp[num_words];
+            std::memcpy(tmp, &u, sizeof(U));
+            for (size_t i = 0; i < num_words; ++i) {
+                words[slot * num_words + i].store(tmp[i], std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<Word> words[Count * num_words];
+    };
+
+    struct Group {
+        static constexpr size_t width = 8;
+
+        // The version should be even, but not necessarily the same after this returns
+        uint32_t read_begin() const
+        {
+            auto v = version.load(std::memory_order_acquire);
+            while (v & 1) {
+                v = version.load(std::memory_order_acquire);
+            }
+            return v;
+        }
+
+        bool read_end(uint32_t v) const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return version.load(std::memory_order_relaxed) == v;
+        }
+
+        // Only called with the stripe lock held
+        void begin_write()
+        {
+            version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void end_write()
+        {
+            version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        uint8_t get_ctrl(uint64_t word, size_t slot) const
+        {
+            return static_cast<uint8_t>(word >> (slot * 8));
+        }
+
+        void set_ctrl(size_t slot, uint8_t c)
+        {
+            auto word = ctrl.load(std::memory_order_relaxed);
+            word &= ~(uint64_t(0xff) << (slot * 8));
+            word |= uint64_t(c) << (slot * 8);
+            ctrl.store(word, std::memory_order_relaxed);
+        }
+
+        bool has_empty() const
+        {
+            const auto word = ctrl.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < width; ++i) {
+                if (get_ctrl(word, i) == CtrlEmpty) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // A torn key or value is harmless, because we will discard it (see read_end)
+        Key load_key(size_t slot) const { return keys.load(slot); }
+        T load_value(size_t slot) const { return values.load(slot); }
+
+        void store(size_t slot, const Key& key, const T& value)
+        {
+            keys.store(slot, key);
+            values.store(slot, value);
+        }
+
+        std::atomic<uint32_t> version { 0 };
+        std::atomic<uint64_t> ctrl { 0 }; // All CtrlEmpty
+        SlotArray<Key, width> keys;
+        SlotArray<T, width> values;
+    };
+
+    struct Table {
+        explicit Table(size_t num_groups)
+            : groups(std::make_unique<Group[]>(num_groups))
+            , group_mask(num_groups - 1)
+        {
+            assert(std::has_single_bit(num_groups));
+        }
+
+        size_t num_groups() const { return group_mask + 1; }
+        size_t capacity() const { return num_groups() * Group::width; }
+        size_t group_index(uint64_t hash) const { return hash & group_mask; }
+
+        // Only called with the stripe lock held. Returns slot = Group::width if not found.
+        std::pair<size_t, size_t> find_slot(
+            const Key& key, uint64_t hash, const KeyEqual& eq) const
+        {
+            const auto tag = h2(hash);
+            auto g = group_index(hash);
+            while (true) {
+                const auto& group = groups[g];
+                const auto word = group.ctrl.load(std::memory_order_relaxed);
+                bool empty = false;
+                for (size_t i = 0; i < Group::width; ++i) {
+                    const auto c = group.get_ctrl(word, i);
+                    if (c == tag && eq(group.load_key(i), key)) {
+                        return { g, i };
+                    }
+                    empty = empty || c == CtrlEmpty;
+                }
+                if (empty) {
+                    return { g, Group::width };
+                }
+                g = (g + 1) & group_mask;
+            }
+        }
+
+        std::pair<size_t, size_t> find_free_slot(uint64_t hash) const
+        {
+            auto g = group_index(hash);
+            while (true) {
+                const auto word = groups[g].ctrl.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < Group::width; ++i) {
+                    if (groups[g].get_ctrl(word, i) < CtrlFull) {
+                        return { g, i };
+                    }
+                }
+                g = (g + 1) & group_mask;
+            }
+        }
+
+        std::unique_ptr<Group[]> groups;
+        size_t group_mask;
+    };
+
+    struct alignas(64) Stripe {
+        std::atomic<const Table*> table { nullptr };
+        std::mutex mutex;
+        // Everything below is only accessed with the mutex held (except size, which is atomic so
+        // size() can read it)
+        std::unique_ptr<Table> current;
+        std::vector<std::unique_ptr<Table>> retired;
+        std::atomic<size_t> size { 0 };
+        size_t tombstones = 0;
+    };
+
+    static size_t max_load(size_t capacity) { return capacity / 4 * 3; }
+
+    static size_t num_groups_for(size_t count)
+    {
+        size_t groups = 1;
+        while (max_load(groups * Group::width) < count) {
+            groups *= 2;
+        }
+        return groups;
+    }
+
+    uint64_t hash_key(const Key& key) const
+    {
+        return detail::mix_hash(static_cast<uint64_t>(hash_(key)));
+    }
+
+    // The high bits select the stripe, the low bits the group and bits 32-38 are stored in the
+    // control byte.
+    static uint8_t h2(uint64_t hash)
+    {
+        return static_cast<uint8_t>(CtrlFull | ((hash >> 32) & 0x7f));
+    }
+
+    size_t stripe_index(uint64_t hash) const
+    {
+        return num_stripes_ > 1 ? static_cast<size_t>(hash >> stripe_shift_) : 0;
+    }
+
+    Stripe& stripe(uint64_t hash) const { return stripes_[stripe_index(hash)]; }
+
+    std::optional<T> find_in(const Table* table, const Key& key, uint64_t hash) const
+    {
+        const auto tag = h2(hash);
+        auto g = table->group_index(hash);
+        while (true) {
+            const auto& group = table->groups[g];
+            const auto version = group.read_begin();
+            const auto word = group.ctrl.load(std::memory_order_relaxed);
+            std::optional<T> result;
+            bool empty = false;
+            for (size_t i = 0; i < Group::width; ++i) {
+                const auto c = group.get_ctrl(word, i);
+                if (c == tag && eq_(group.load_key(i), key)) {
+                    result = group.load_value(i);
+                    break;
+                }
+                empty = empty || c == CtrlEmpty;
+            }
+            if (!group.read_end(version)) {
+                continue; // retry this group
+            }
+            if (result || empty) {
+                return result;
+            }
+            g = (g + 1) & table->group_mask;
+        }
+    }
+
+    bool insert_locked(Stripe& s, const Key& key, const T& value, uint64_t hash, bool assign)
+    {
+        auto table = s.current.get();
+        const auto [found_group, found_slot] = table->find_slot(key, hash, eq_);
+        if (found_slot != Group::width) {
+            if (assign) {
+                auto& group = table->groups[found_group];
+                group.begin_write();
+                group.store(found_slot, key, value);
+                group.end_write();
+            }
+            return false;
+        }
+
+        const auto size = s.size.load(std::memory_order_relaxed);
+        if (size + s.tombstones + 1 > max_load(table->capacity())) {
+            grow(s);
+            table = s.current.get();
+        }
+
+        const auto [group_idx, slot] = table->find_free_slot(hash);
+        auto& group = table->groups[group_idx];
+        const auto word = group.ctrl.load(std::memory_order_relaxed);
+        if (group.get_ctrl(word, slot) == CtrlDeleted) {
+            s.tombstones--;
+        }
+        group.begin_write();
+        group.store(slot, key, value);
+        group.set_ctrl(slot, h2(hash));
+        group.end_write();
+        s.size.store(size + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void grow(Stripe& s)
+    {
+        const auto old = s.current.get();
+        const auto size = s.size.load(std::memory_order_relaxed);
+        // If there are many tombstones, rebuilding at the same size is enough
+        const auto grow = size + 1 > max_load(old->capacity()) / 2;
+        auto table = std::make_unique<Table>(old->num_groups() * (grow ? 2 : 1));
+        // The new table is not visible to readers yet, so we don't need to bump versions
+        for (size_t g = 0; g < old->num_groups(); ++g) {
+            const auto& group = old->groups[g];
+            const auto word = group.ctrl.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < Group::width; ++i) {
+                const auto c = group.get_ctrl(word, i);
+                if (c >= CtrlFull) {
+                    const auto key = group.load_key(i);
+                    const auto [ng, ns] = table->find_free_slot(hash_key(key));
+                    table->groups[ng].store(ns, key, group.load_value(i));
+                    table->groups[ng].set_ctrl(ns, c);
+                }
+            }
+        }
+        s.table.store(table.get(), std::memory_order_release);
+        s.retired.push_back(std::move(s.current));
+        s.current = std::move(table);
+        s.tombstones = 0;
+    }
+
+    Hash hash_;
+    KeyEqual eq_;
+    std::unique_ptr<Stripe[]> stripes_;
+    size_t num_stripes_ = 0;
+    unsigned stripe_shift_ = 0;
+};
+
+}
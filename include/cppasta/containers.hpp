@@ -1,7 +1,21 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstdint>
+#include <iterator>
 #include <optional>
+#include <ranges>
+#include <type_traits>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace pasta {
 
 template <typename MapType, typename OutContainer = std::vector<typename MapType::key_type>>
@@ -32,6 +46,9 @@ template <typename InContainer, typename Func,
 OutContainer transform(const InContainer& in, Func&& func)
 {
     OutContainer out;
+    if constexpr (requires { out.reserve(in.size()); }) {
+        out.reserve(in.size());
+    }
     for (const auto& v : in) {
         out.push_back(func(v));
     }
@@ -63,13 +80,181 @@ std::vector<Index> range(Index num)
     return range<Index>(0, num, 1);
 }
 
+namespace detail {
+    // Searching for values in contiguous arrays of arithmetic types or enums (i.e. ids) compares
+    // a whole vector register at a time (AVX2 if enabled, SSE2 otherwise).
+    template <typename T>
+    concept SimdComparable = (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+        && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+    template <typename T, typename Value>
+    concept SimdComparableWith = SimdComparable<T>
+        && (std::is_same_v<T, Value>
+            || (std::is_arithmetic_v<T> && std::is_arithmetic_v<Value>
+                // Ints are compared as floats in that case, which we can't do the same way
+                && !(std::is_integral_v<T> && std::is_floating_point_v<Value>)));
+
+    template <typename Container, typename Value>
+    concept SimdSearchable = std::ranges::contiguous_range<const Container>
+        && SimdComparableWith<std::ranges::range_value_t<const Container>, Value>;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#if defined(__AVX2__)
+    constexpr size_t SimdBytes = 32;
+#else
+    constexpr size_t SimdBytes = 16;
+#endif
+
+    // Returns a mask with sizeof(T) bits set for every element in [data, data + SimdBytes) that
+    // is equal to value
+    template <typename T>
+    uint32_t equalMask(const T* data, T value)
+    {
+#if defined(__AVX2__)
+        if constexpr (std::is_same_v<T, float>) {
+            const auto eq = _mm256_cmp_ps(_mm256_loadu_ps(data), _mm256_set1_ps(value), _CMP_EQ_OQ);
+            return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_castps_si256(eq)));
+        } else if constexpr (std::is_same_v<T, double>) {
+            const auto eq = _mm256_cmp_pd(_mm256_loadu_pd(data), _mm256_set1_pd(value), _CMP_EQ_OQ);
+            return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_castpd_si256(eq)));
+        } else {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            __m256i eq;
+            if constexpr (sizeof(T) == 1) {
+                eq = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(std::bit_cast<char>(value)));
+            } else if constexpr (sizeof(T) == 2) {
+                eq = _mm256_cmpeq_epi16(v, _mm256_set1_epi16(std::bit_cast<int16_t>(value)));
+            } else if constexpr (sizeof(T) == 4) {
+                eq = _mm256_cmpeq_epi32(v, _mm256_set1_epi32(std::bit_cast<int32_t>(value)));
+            } else {
+                eq = _mm256_cmpeq_epi64(v, _mm256_set1_epi64x(std::bit_cast<int64_t>(value)));
+            }
+            return static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        }
+#else
+        if constexpr (std::is_same_v<T, float>) {
+            const auto eq = _mm_cmpeq_ps(_mm_loadu_ps(data), _mm_set1_ps(value));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_castps_si128(eq)));
+        } else if constexpr (std::is_same_v<T, double>) {
+            const auto eq = _mm_cmpeq_pd(_mm_loadu_pd(data), _mm_set1_pd(value));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_castpd_si128(eq)));
+        } else {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            __m128i eq;
+            if constexpr (sizeof(T) == 1) {
+                eq = _mm_cmpeq_epi8(v, _mm_set1_epi8(std::bit_cast<char>(value)));
+            } else if constexpr (sizeof(T) == 2) {
+                eq = _mm_cmpeq_epi16(v, _mm_set1_epi16(std::bit_cast<int16_t>(value)));
+            } else if constexpr (sizeof(T) == 4) {
+                eq = _mm_cmpeq_epi32(v, _mm_set1_epi32(std::bit_cast<int32_t>(value)));
+            } else {
+                // There is no 64-bit compare in SSE2, so both 32-bit halves have to be equal
+                const auto value_v = _mm_set1_epi64x(std::bit_cast<int64_t>(value));
+                const auto eq32 = _mm_cmpeq_epi32(v, value_v);
+                eq = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+            }
+            return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+        }
+#endif
+    }
+#endif
+
+    // Returns size if value is not found
+    template <typename T>
+    size_t findValue(const T* data, size_t size, T value)
+    {
+        size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+        constexpr auto width = SimdBytes / sizeof(T);
+        for (; i + width <= size; i += width) {
+            const auto mask = equalMask(data + i, value);
+            if (mask) {
+                return i + static_cast<size_t>(std::countr_zero(mask)) / sizeof(T);
+            }
+        }
+#endif
+        for (; i < size; ++i) {
+            if (data[i] == value) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+    template <typename T>
+    size_t countValue(const T* data, size_t size, T value)
+    {
+        size_t i = 0;
+        size_t count = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+        constexpr auto width = SimdBytes / sizeof(T);
+        for (; i + width <= size; i += width) {
+            count += static_cast<size_t>(std::popcount(equalMask(data + i, value))) / sizeof(T);
+        }
+#endif
+        for (; i < size; ++i) {
+            count += data[i] == value;
+        }
+        return count;
+    }
+
+    // Converts value to the element type, so that comparing in the element type gives the same
+    // result as comparing with operator== (i.e. in the common type). Returns std::nullopt if no
+    // element can be equal to value.
+    template <typename T, typename Value>
+    std::optional<T> toElementType(const Value& value)
+    {
+        if constexpr (std::is_same_v<T, Value>) {
+            return value;
+        } else {
+            using C = std::common_type_t<T, Value>;
+            const auto converted = static_cast<T>(value);
+            if (static_cast<C>(converted) != static_cast<C>(value)) {
+                return std::nullopt;
+            }
+            return converted;
+        }
+    }
+}
+
 template <typename Container, typename Value>
 std::optional<std::ptrdiff_t> indexOf(const Container& container, const Value& findVal)
 {
-    auto it = std::find(container.begin(), container.end(), findVal);
-    if (it == container.end())
-        return std::nullopt;
-    return std::distance(container.begin(), it);
+    if constexpr (detail::SimdSearchable<Container, Value>) {
+        using T = std::ranges::range_value_t<const Container>;
+        const auto value = detail::toElementType<T>(findVal);
+        const auto size = std::ranges::size(container);
+        const auto idx
+            = value ? detail::findValue(std::ranges::data(container), size, *value) : size;
+        if (idx == size)
+            return std::nullopt;
+        return static_cast<std::ptrdiff_t>(idx);
+    } else {
+        auto it = std::find(container.begin(), container.end(), findVal);
+        if (it == container.end())
+            return std::nullopt;
+        return std::distance(container.begin(), it);
+    }
+}
+
+template <typename Container, typename Value>
+bool contains(const Container& container, const Value& findVal)
+{
+    return indexOf(container, findVal).has_value();
+}
+
+template <typename Container, typename Value>
+size_t count(const Container& container, const Value& findVal)
+{
+    if constexpr (detail::SimdSearchable<Container, Value>) {
+        using T = std::ranges::range_value_t<const Container>;
+        const auto value = detail::toElementType<T>(findVal);
+        return value
+            ? detail::countValue(std::ranges::data(container), std::ranges::size(container), *value)
+            : 0;
+    } else {
+        return static_cast<size_t>(std::count(container.begin(), container.end(), findVal));
+    }
 }
 
 }
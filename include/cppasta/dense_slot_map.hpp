@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
+#include <span>
+#include <utility>
 
 #include "generational_index.hpp"
+#include "prefetch.hpp"
 
 /* DenseSlotMap
 
@@ -20,7 +25,9 @@ another container first) and you do not have stable addresses anymore, as object
 around in the data storage (to fill gaps).
 
 For data storage vector is probably a good default. Use deque if you want the slot map to grow
-often and copying/moving T isn't cheap.
+often and copying/moving T isn't cheap. Use IncrementalVector (incremental_vector.hpp) for both
+storages if no single insert may take long (growing doesn't move everything at once), but then
+get_key doesn't work and the growth factor should be at least 2 (see IncrementalVector).
 
 Use adapter for custom allocators:
     template <typename T> using Storage = std::vector<T, MyAllocator>;
@@ -39,68 +46,52 @@ public:
     // not increase it's size (e.g. with the default arguments of 0 and 1.0 respectively), the map
     // will simply fail an assertion when it needs to resize and can't.
     DenseSlotMap(size_t capacity, size_t growth_constant = 0, float growth_factor = 1.0f)
-        : indices_(capacity)
+        : capacity_(capacity)
         , growth_constant_(growth_constant)
         , growth_factor_(growth_factor)
     {
         data_.reserve(capacity);
         backrefs_.reserve(capacity);
-        // Initialize free list
-        for (size_t i = 0; i < indices_.size(); ++i) {
-            indices_[i] = Key(i + 1, 1);
-        }
+        indices_.reserve(capacity);
     }
 
+    // Does nothing if size is not larger than the current capacity
     void reserve(size_t size)
     {
+        if (size <= capacity_) {
+            return;
+        }
         data_.reserve(size);
         backrefs_.reserve(size);
-
-        const auto old_size = indices_.size();
-        indices_.resize(size);
-
-        for (size_t i = old_size; i < size; ++i) {
-            indices_[i] = Key(i + 1, 1);
-        }
-
-        const auto old_free_head = free_list_head_;
-        free_list_head_ = old_size;
-        indices_[size - 1] = Key(old_free_head, 1);
+        indices_.reserve(size);
+        capacity_ = size;
     }
 
-    Key insert(const T& value) { return insert(T { value }); }
-
-    Key insert(T&& value)
+    // Constructs the element directly in data_ (with DataStorage::emplace_back)
+    template <typename... Args>
+    Key emplace(Args&&... args)
     {
-        if (indices_.size() == data_.size()) {
-            assert(indices_.size() == data_.size());
-            const auto new_size
-                = static_cast<size_t>(data_.size() * growth_factor_) + growth_constant_;
-            assert(new_size > indices_.size() && "DenseSlotMap full");
-            reserve(new_size);
+        if (data_.size() == capacity_) {
+            // args might refer to an element of this map (e.g. `emplace(*get(key))`), which growing
+            // might move, so we construct the new element before.
+            T value(std::forward<Args>(args)...);
+            grow();
+            return emplace_free(std::move(value));
         }
+        return emplace_free(std::forward<Args>(args)...);
+    }
 
-        assert(free_list_head_ < indices_.size());
-        const auto indices_idx = free_list_head_;
-        free_list_head_ = indices_[free_list_head_].idx();
-
-        const auto data_idx = data_.size();
-        data_.push_back(std::move(value));
-        backrefs_.push_back(indices_idx);
+    Key insert(const T& value) { return emplace(value); }
 
-        const auto gen = indices_[indices_idx].gen();
-        indices_[indices_idx] = Key(data_idx, gen);
-        return Key(indices_idx, gen);
-    }
+    Key insert(T&& value) { return emplace(std::move(value)); }
 
     bool remove(Key key)
     {
-        const auto data_idx = indices_[key.idx()].idx();
-        const auto last_idx = data_.size() - 1;
-
         if (!contains(key)) {
             return false;
         }
+        const auto data_idx = indices_[key.idx()].idx();
+        const auto last_idx = data_.size() - 1;
 
         // Swap and pop the data
         std::swap(data_[data_idx], data_[last_idx]);
@@ -109,14 +100,17 @@ public:
         backrefs_.pop_back();
 
         // Update index for swapped element (last element before swap, now at data_idx) to point to
-        // data_idx.
-        const auto backref = backrefs_[data_idx];
-        indices_[backref] = Key(data_idx, indices_[backref].gen());
+        // data_idx. If we removed the last element, there is nothing left at data_idx.
+        if (data_idx != last_idx) {
+            const auto backref = backrefs_[data_idx];
+            indices_[backref] = Key(data_idx, indices_[backref].gen());
+        }
 
-        // Invalidate old key (increased stored generation) and put at the front of the free list
-        const auto old_free_head = free_list_head_;
+        // Invalidate old key (increased stored generation) and put at the front of the free list.
+        // The last entry of the free list points to itself.
+        const auto next_free = free_list_head_ != FreeListEnd ? free_list_head_ : key.idx();
         free_list_head_ = key.idx();
-        indices_[key.idx()] = Key(old_free_head, key.gen()).next_generation();
+        indices_[key.idx()] = Key(next_free, key.gen()).next_generation();
 
         return true;
     }
@@ -125,8 +119,8 @@ public:
 
     bool contains(const Key& key) const
     {
-        assert(key.idx() < indices_.size());
-        return indices_[key.idx()].gen() == key.gen();
+        assert(key.idx() < capacity_);
+        return key.idx() < indices_.size() && indices_[key.idx()].gen() == key.gen();
     }
 
     T* find(Key key) { return contains(key) ? get(key) : nullptr; }
@@ -144,6 +138,31 @@ public:
         return &data_[indices_[key.idx()].idx()];
     }
 
+    // Resolves many keys at once: out[i] = find(keys[i]). Lookups need two dependent loads
+    // (indices_, then data_), so the indices_ entries are prefetched 2 * PrefetchDistance keys
+    // ahead and the data_ entries (using the then hopefully cached indices_ entries)
+    // PrefetchDistance keys ahead.
+    void find_many(std::span<const Key> keys, std::span<T*> out)
+    {
+        lookup_many<false>(*this, keys, out);
+    }
+
+    void find_many(std::span<const Key> keys, std::span<const T*> out) const
+    {
+        lookup_many<false>(*this, keys, out);
+    }
+
+    // Like find_many, but all keys must be contained
+    void get_many(std::span<const Key> keys, std::span<T*> out)
+    {
+        lookup_many<true>(*this, keys, out);
+    }
+
+    void get_many(std::span<const Key> keys, std::span<const T*> out) const
+    {
+        lookup_many<true>(*this, keys, out);
+    }
+
     // Mostly useful if you want to remove during iteration or something.
     // ONLY WORKS FOR CONTIGUOUS STORAGE
     Key get_key(const T* element) const
@@ -158,7 +177,7 @@ public:
     // Just use begin/end/data.
 
     size_t size() const { return data_.size(); }
-    size_t capacity() const { return indices_.size(); }
+    size_t capacity() const { return capacity_; }
 
     auto begin() { return data_.begin(); }
     auto begin() const { return data_.begin(); }
@@ -172,6 +191,71 @@ public:
     auto free_head() const { return free_list_head_; }
 
 private:
+    void grow()
+    {
+        const auto new_size = static_cast<size_t>(data_.size() * growth_factor_) + growth_constant_;
+        assert(new_size > capacity_ && "DenseSlotMap full");
+        reserve(new_size);
+    }
+
+    // Takes an indices_ entry from the free list or appends a new one if it's empty
+    template <typename... Args>
+    Key emplace_free(Args&&... args)
+    {
+        assert(data_.size() < capacity_);
+        const auto from_free_list = free_list_head_ != FreeListEnd;
+        const auto indices_idx = from_free_list ? free_list_head_ : indices_.size();
+
+        const auto data_idx = data_.size();
+        data_.emplace_back(std::forward<Args>(args)...);
+        backrefs_.push_back(indices_idx);
+
+        if (from_free_list) {
+            const auto next_free = indices_[indices_idx].idx();
+            free_list_head_ = next_free != indices_idx ? next_free : FreeListEnd;
+            indices_[indices_idx] = Key(data_idx, indices_[indices_idx].gen());
+        } else {
+            indices_.push_back(Key(data_idx, 1));
+        }
+        return Key(indices_idx, indices_[indices_idx].gen());
+    }
+
+    template <bool AllContained, typename Self, typename Ptr>
+    static void lookup_many(Self& self, std::span<const Key> keys, std::span<Ptr> out)
+    {
+        assert(out.size() >= keys.size());
+        const auto prefetch_index = [&self](Key key) {
+            if (key.idx() < self.indices_.size()) {
+                prefetch(&self.indices_[key.idx()]);
+            }
+        };
+        const auto prefetch_data = [&self](Key key) {
+            // For keys that are not contained, the indices_ entry is a free list entry
+            if (key.idx() < self.indices_.size() && (AllContained || self.contains(key))) {
+                prefetch(&self.data_[self.indices_[key.idx()].idx()]);
+            }
+        };
+        for (size_t i = 0; i < std::min(keys.size(), 2 * PrefetchDistance); ++i) {
+            prefetch_index(keys[i]);
+        }
+        for (size_t i = 0; i < std::min(keys.size(), PrefetchDistance); ++i) {
+            prefetch_data(keys[i]);
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (i + 2 * PrefetchDistance < keys.size()) {
+                prefetch_index(keys[i + 2 * PrefetchDistance]);
+            }
+            if (i + PrefetchDistance < keys.size()) {
+                prefetch_data(keys[i + PrefetchDistance]);
+            }
+            if constexpr (AllContained) {
+                out[i] = self.get(keys[i]);
+            } else {
+                out[i] = self.find(keys[i]);
+            }
+        }
+    }
+
     // data_ has the actual data
     DataStorage<T> data_;
     /* indices_ is the map that maps key.idx() to an index for data_. It also stores the generation
@@ -181,7 +265,8 @@ private:
        index is just the one in `indices_[key.idx()].gen()`.
 
        If an element is unused and doesn't point to an element in data_, it will be used as a free
-       list entry (see below).
+       list entry (see below). It only contains entries that were used at some point, so it grows
+       when the free list is empty, instead of being initialized for the whole capacity up front.
     */
     MetaStorage<Key> indices_;
     /* If an element in the middle is removed, the last element is moved into that spot, meaning
@@ -195,9 +280,12 @@ private:
     /* indices_ is NOT dense (i.e. has gaps), so we need to reuse elements and therefore need to
        keep a free list. Instead of a separate data structure, we simply reuse unused indices_
        elements as free list entries. free_list_head_ will point to the first unused indices_ entry
-       and that entry itself (idx()) will point to the next free entry.
+       and that entry itself (idx()) will point to the next free entry (or itself, if it's the last
+       one).
     */
-    size_t free_list_head_ = 0;
+    static constexpr size_t FreeListEnd = std::numeric_limits<size_t>::max();
+    size_t free_list_head_ = FreeListEnd;
+    size_t capacity_ = 0;
     size_t growth_constant_ = 0;
     float growth_factor_ = 0.0f;
 };
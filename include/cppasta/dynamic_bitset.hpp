@@ -0,0 +1,205 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <vector>
+
+/* DynamicBitset
+
+A heap allocated bitset with a size that is only known at runtime (unlike std::bitset) and without
+the proxy references of std::vector<bool>. Bits are stored in 64-bit words, which is 8x less
+memory than a byte per flag and allows to skip 64 unset bits at a time when scanning.
+
+find_next_set/find_next_unset, count and the bulk operations (&=, |=, ^=, -=) work on whole words
+and use AVX2 if the library is built with CPPASTA_ENABLE_AVX2 (SSE2 or plain words otherwise).
+The bits past size() in the last word are always kept zero.
+*/
+
+namespace pasta {
+
+class DynamicBitset {
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    class SetBitIterator;
+
+    DynamicBitset() = default;
+    DynamicBitset(size_t size, bool value = false);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // New bits are initialized to value
+    void resize(size_t size, bool value = false);
+    void clear();
+
+    bool test(size_t idx) const
+    {
+        assert(idx < size_);
+        return (words_[idx / 64] >> (idx % 64)) & 1;
+    }
+
+    bool operator[](size_t idx) const { return test(idx); }
+
+    void set(size_t idx)
+    {
+        assert(idx < size_);
+        words_[idx / 64] |= bit(idx);
+    }
+
+    void set(size_t idx, bool value)
+    {
+        assert(idx < size_);
+        // Branchless, because value is often random
+        auto& word = words_[idx / 64];
+        word = (word & ~bit(idx)) | (static_cast<uint64_t>(value) << (idx % 64));
+    }
+
+    void reset(size_t idx)
+    {
+        assert(idx < size_);
+        words_[idx / 64] &= ~bit(idx);
+    }
+
+    void flip(size_t idx)
+    {
+        assert(idx < size_);
+        words_[idx / 64] ^= bit(idx);
+    }
+
+    // All bits
+    void set();
+    void reset();
+    void flip();
+
+    // [begin, end)
+    void set_range(size_t begin, size_t end);
+    void reset_range(size_t begin, size_t end);
+
+    size_t count() const;
+    bool any() const;
+    bool none() const { return !any(); }
+    bool all() const;
+
+    // Returns the index of the first set bit >= pos or npos
+    size_t find_next_set(size_t pos) const;
+    size_t find_first_set() const { return find_next_set(0); }
+    // Returns the index of the first unset bit >= pos or npos
+    size_t find_next_unset(size_t pos) const;
+    size_t find_first_unset() const { return find_next_unset(0); }
+
+    // The sizes have to match
+    DynamicBitset& operator&=(const DynamicBitset& other);
+    DynamicBitset& operator|=(const DynamicBitset& other);
+    DynamicBitset& operator^=(const DynamicBitset& other);
+    // and not
+    DynamicBitset& operator-=(const DynamicBitset& other);
+
+    bool operator==(const DynamicBitset& other) const = default;
+
+    // Calls func(size_t) for every set bit in ascending order
+    template <typename Func>
+    void for_each_set(Func&& func) const
+    {
+        for (size_t w = 0; w < words_.size(); ++w) {
+            auto word = words_[w];
+            while (word) {
+                func(w * 64 + static_cast<size_t>(std::countr_zero(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    // Range over the indices of all set bits, i.e. `for (const auto idx : bitset.set_bits())`
+    struct SetBits {
+        const DynamicBitset* bitset;
+        SetBitIterator begin() const;
+        SetBitIterator end() const;
+    };
+
+    SetBits set_bits() const { return SetBits { this }; }
+
+    std::span<const uint64_t> words() const { return words_; }
+
+private:
+    static uint64_t bit(size_t idx) { return uint64_t(1) << (idx % 64); }
+    static size_t num_words(size_t size) { return (size + 63) / 64; }
+
+    // Clears the bits past size_ in the last word
+    void clear_padding();
+
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+};
+
+class DynamicBitset::SetBitIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const size_t*;
+    using reference = size_t;
+
+    SetBitIterator() = default;
+    SetBitIterator(const DynamicBitset* bitset, size_t idx) : bitset_(bitset), idx_(idx) { }
+
+    size_t operator*() const { return idx_; }
+
+    SetBitIterator& operator++()
+    {
+        idx_ = idx_ + 1 < bitset_->size() ? bitset_->find_next_set(idx_ + 1) : npos;
+        return *this;
+    }
+
+    SetBitIterator operator++(int)
+    {
+        auto ret = *this;
+        ++*this;
+        return ret;
+    }
+
+    bool operator==(const SetBitIterator& other) const { return idx_ == other.idx_; }
+
+private:
+    const DynamicBitset* bitset_ = nullptr;
+    size_t idx_ = npos;
+};
+
+inline DynamicBitset::SetBitIterator DynamicBitset::SetBits::begin() const
+{
+    return SetBitIterator(bitset, bitset->find_first_set());
+}
+
+inline DynamicBitset::SetBitIterator DynamicBitset::SetBits::end() const
+{
+    return SetBitIterator(bitset, npos);
+}
+
+inline DynamicBitset operator&(DynamicBitset a, const DynamicBitset& b)
+{
+    a &= b;
+    return a;
+}
+
+inline DynamicBitset operator|(DynamicBitset a, const DynamicBitset& b)
+{
+    a |= b;
+    return a;
+}
+
+inline DynamicBitset operator^(DynamicBitset a, const DynamicBitset& b)
+{
+    a ^= b;
+    return a;
+}
+
+inline DynamicBitset operator-(DynamicBitset a, const DynamicBitset& b)
+{
+    a -= b;
+    return a;
+}
+
+}
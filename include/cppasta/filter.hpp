@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Filter kernels
+
+compact_if(in, pred, out) copies all elements for which pred(elem) is true to the front of out
+(keeping their order) and returns their number. select_indices(in, pred, out) does the same, but
+writes the indices of the elements instead. select_keys(map, pred) returns the keys of all
+elements of a DenseSlotMap (or anything with contiguous data and get_key(const T*)) for which pred
+is true.
+
+These are for culling and filtering large arrays (visible, alive, in range), where an if per
+element mispredicts a lot. The predicate is evaluated for a block of elements into a bit mask and
+the selected elements (or their indices) are then written with a single compress (AVX-512) or
+permute (AVX2, with a lookup table from mask to lane order) and store. Elements that are not 4 or
+8 bytes or not trivially copyable are handled one at a time, but still without branching if they
+are trivially copyable.
+
+out must have room for in.size() elements, because whole vectors are written (and only the first
+count elements of out are meaningful afterwards). out may be the same range as in.
+The predicate is called exactly once for every element, in order.
+*/
+
+namespace pasta {
+
+namespace detail {
+    template <typename T>
+    concept Compressible = std::is_trivially_copyable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+    // Returns a mask with bit j set if pred(data[j]) is true
+    template <size_t Lanes, typename T, typename Pred>
+    uint32_t predicate_mask(const T* data, Pred& pred)
+    {
+        uint32_t mask = 0;
+        for (size_t j = 0; j < Lanes; ++j) {
+            mask |= static_cast<uint32_t>(static_cast<bool>(pred(data[j]))) << j;
+        }
+        return mask;
+    }
+
+#if defined(__AVX512F__)
+    constexpr size_t CompressBytes = 64;
+#elif defined(__AVX2__)
+    constexpr size_t CompressBytes = 32;
+
+    // For every 8 bit mask the indices of the set bits, one per byte (padded with zeros)
+    constexpr auto compress_lut = [] {
+        std::array<uint64_t, 256> lut {};
+        for (size_t mask = 0; mask < 256; ++mask) {
+            size_t n = 0;
+            for (uint64_t lane = 0; lane < 8; ++lane) {
+                if (mask & (1 << lane)) {
+                    lut[mask] |= lane << (n++ * 8);
+                }
+            }
+        }
+        return lut;
+    }();
+
+    // 32-bit lane order to compress the 64-bit lanes set in a 4 bit mask
+    inline __m256i compress_permutation(uint32_t mask, size_t elem_size)
+    {
+        if (elem_size == 8) {
+            // Every 64-bit lane is two 32-bit lanes, so every mask bit is duplicated
+            mask = (mask & 1) * 0x3 | (mask & 2) * 0x6 | (mask & 4) * 0xc | (mask & 8) * 0x18;
+        }
+        return _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<int64_t>(compress_lut[mask])));
+    }
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+    template <Compressible T>
+    constexpr size_t CompressLanes = CompressBytes / sizeof(T);
+
+    // Writes the elements of in[0, CompressLanes<T>) selected by mask to out[0, popcount(mask)).
+    // Writes a whole vector to out.
+    template <Compressible T>
+    void compress_store(const T* in, uint32_t mask, T* out)
+    {
+#if defined(__AVX512F__)
+        const auto v = _mm512_loadu_si512(in);
+        if constexpr (sizeof(T) == 4) {
+            _mm512_storeu_si512(out, _mm512_maskz_compress_epi32(static_cast<__mmask16>(mask), v));
+        } else {
+            _mm512_storeu_si512(out, _mm512_maskz_compress_epi64(static_cast<__mmask8>(mask), v));
+        }
+#else
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        const auto compressed
+            = _mm256_permutevar8x32_epi32(v, compress_permutation(mask, sizeof(T)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), compressed);
+#endif
+    }
+
+    // Writes the indices base + j for every bit j set in mask (16 lanes for AVX-512, 8 for AVX2)
+    inline void compress_indices(uint32_t base, uint32_t mask, uint32_t* out)
+    {
+#if defined(__AVX512F__)
+        const auto indices = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int32_t>(base)),
+            _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        const auto compressed = _mm512_maskz_compress_epi32(static_cast<__mmask16>(mask), indices);
+        _mm512_storeu_si512(out, compressed);
+#else
+        const auto indices = _mm256_add_epi32(
+            _mm256_set1_epi32(static_cast<int32_t>(base)), compress_permutation(mask, 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), indices);
+#endif
+    }
+#endif
+
+    template <typename In, typename Out>
+    concept CompactableInto = std::ranges::contiguous_range<In>
+        && std::ranges::contiguous_range<Out>
+        && std::is_same_v<std::ranges::range_value_t<In>, std::ranges::range_value_t<Out>>;
+}
+
+template <std::ranges::contiguous_range In, typename Pred, std::ranges::contiguous_range Out>
+    requires detail::CompactableInto<const In, Out>
+size_t compact_if(const In& in, Pred&& pred, Out& out)
+{
+    using T = std::ranges::range_value_t<const In>;
+    const auto size = std::ranges::size(in);
+    assert(std::ranges::size(out) >= size);
+    const T* src = std::ranges::data(in);
+    T* dst = std::ranges::data(out);
+    size_t i = 0;
+    size_t n = 0;
+#if defined(__AVX512F__) || defined(__AVX2__)
+    if constexpr (detail::Compressible<T>) {
+        constexpr auto lanes = detail::CompressLanes<T>;
+        for (; i + lanes <= size; i += lanes) {
+            const auto mask = detail::predicate_mask<lanes>(src + i, pred);
+            detail::compress_store(src + i, mask, dst + n);
+            n += static_cast<size_t>(std::popcount(mask));
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            // Writing unconditionally is fine, because n <= i
+            const auto selected = static_cast<bool>(pred(src[i]));
+            dst[n] = src[i];
+            n += selected;
+        } else if (pred(src[i])) {
+            dst[n++] = src[i];
+        }
+    }
+    return n;
+}
+
+template <std::ranges::contiguous_range In, typename Pred, std::ranges::contiguous_range Out>
+    requires std::is_same_v<std::ranges::range_value_t<Out>, uint32_t>
+size_t select_indices(const In& in, Pred&& pred, Out& out)
+{
+    const auto size = std::ranges::size(in);
+    assert(size <= std::numeric_limits<uint32_t>::max());
+    assert(std::ranges::size(out) >= size);
+    const auto src = std::ranges::data(in);
+    uint32_t* dst = std::ranges::data(out);
+    size_t i = 0;
+    size_t n = 0;
+#if defined(__AVX512F__) || defined(__AVX2__)
+    constexpr size_t lanes = detail::CompressBytes / sizeof(uint32_t);
+    for (; i + lanes <= size; i += lanes) {
+        const auto mask = detail::predicate_mask<lanes>(src + i, pred);
+        detail::compress_indices(static_cast<uint32_t>(i), mask, dst + n);
+        n += static_cast<size_t>(std::popcount(mask));
+    }
+#endif
+    for (; i < size; ++i) {
+        const auto selected = static_cast<bool>(pred(src[i]));
+        dst[n] = static_cast<uint32_t>(i);
+        n += selected;
+    }
+    return n;
+}
+
+template <std::ranges::contiguous_range In, typename Pred>
+std::vector<uint32_t> select_indices(const In& in, Pred&& pred)
+{
+    std::vector<uint32_t> indices(std::ranges::size(in));
+    indices.resize(select_indices(in, pred, indices));
+    return indices;
+}
+
+// Map needs contiguous storage (see DenseSlotMap::get_key)
+template <std::ranges::contiguous_range Map, typename Pred>
+std::vector<typename Map::Key> select_keys(const Map& map, Pred&& pred)
+{
+    const auto indices = select_indices(map, pred);
+    const auto data = std::ranges::data(map);
+    std::vector<typename Map::Key> keys;
+    keys.reserve(indices.size());
+    for (const auto idx : indices) {
+        keys.push_back(map.get_key(data + idx));
+    }
+    return keys;
+}
+
+}
@@ -0,0 +1,751 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* flat_hash_map / flat_hash_set
+
+An open addressing hash table in the style of Abseil's Swiss tables.
+
+Next to the slot array there is an array of control bytes, one per slot. A control byte is either
+CtrlEmpty, CtrlDeleted (a tombstone) or, if the slot is full, the 7 lowest bits of the hash of the
+element in it (h2). The remaining bits of the hash (h1) select a group of 16 slots to start probing
+at. For every group we then compare all 16 control bytes against h2 at once (a single SSE2 compare
+and movemask) and only have to compare keys of slots that have a matching control byte, which is
+almost always exactly the one we are looking for. If a group contains an empty slot, the probe
+sequence ends.
+
+Groups start at slot indices that are multiples of the group width (the capacity is a multiple of
+it too), so a group is always completely probed or not at all. The addresses of the control bytes
+don't have to be aligned. This allows us to erase without leaving a tombstone most of the
+time: if the group of an erased slot still contains an empty slot, it has never been full (empty
+slots only ever become full or deleted until the next rehash), so no probe sequence ever went past
+it and we can simply mark the slot as empty again.
+
+The maximum load factor is 7/8 (tombstones included). If there is no room left, we rehash into a
+table of the same size if at least half of the used slots are tombstones, otherwise we double the
+capacity.
+
+Iterators and references are invalidated by rehashing (i.e. by insertion without reserve), but not
+by erasure.
+
+Lookup is heterogeneous if both Hash and KeyEqual define is_transparent.
+*/
+
+namespace pasta {
+
+namespace detail {
+    constexpr int8_t CtrlEmpty = -128; // 0b10000000
+    constexpr int8_t CtrlDeleted = -2; // 0b11111110
+
+    // murmur3's finalizer. std::hash is the identity for integers on all major standard libraries
+    // and we need good entropy in the high and the low bits.
+    inline uint64_t mix_hash(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    struct HashGroup {
+        static constexpr size_t width = 16;
+
+        // The control bytes come from the (rebound) user allocator, which only guarantees alignment
+        // for int8_t, so this has to be an unaligned load. It's as fast as an aligned one if the
+        // address happens to be aligned anyways.
+        explicit HashGroup(const int8_t* ctrl)
+        {
+#if defined(__SSE2__)
+            ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+            std::memcpy(ctrl_, ctrl, width);
+#endif
+        }
+
+        // All of these return a bitmask with bit i set if ctrl[i] matches
+        uint32_t match(int8_t h2) const
+        {
+#if defined(__SSE2__)
+            return static_cast<uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < width; ++i) {
+                mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+            }
+            return mask;
+#endif
+        }
+
+        uint32_t match_empty() const { return match(CtrlEmpty); }
+
+        // Empty and deleted are the only negative values smaller than -1
+        uint32_t match_empty_or_deleted() const
+        {
+#if defined(__SSE2__)
+            return static_cast<uint32_t>(
+                _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl_)));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < width; ++i) {
+                mask |= static_cast<uint32_t>(ctrl_[i] < -1) << i;
+            }
+            return mask;
+#endif
+        }
+
+        uint32_t match_full() const { return ~match_empty_or_deleted() & 0xffff; }
+
+#if defined(__SSE2__)
+        __m128i ctrl_;
+#else
+        int8_t ctrl_[width];
+#endif
+    };
+
+    // An alias template (instead of std::conditional_t) keeps K deducible if transparent is true
+    template <bool transparent>
+    struct KeyArg {
+        template <typename K, typename Key>
+        using type = K;
+    };
+
+    template <>
+    struct KeyArg<false> {
+        template <typename K, typename Key>
+        using type = Key;
+    };
+
+    template <typename Key, typename T>
+    struct FlatMapPolicy {
+        using key_type = Key;
+        using value_type = std::pair<const Key, T>;
+        static const Key& key(const value_type& v) { return v.first; }
+    };
+
+    template <typename Key>
+    struct FlatSetPolicy {
+        using key_type = Key;
+        using value_type = Key;
+        static const Key& key(const value_type& v) { return v; }
+    };
+
+    template <typename Policy, typename Hash, typename KeyEqual, typename Allocator>
+    class FlatHashTable {
+    public:
+        using key_type = typename Policy::key_type;
+        using value_type = typename Policy::value_type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+        using allocator_type = Allocator;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using pointer = typename std::allocator_traits<allocator_type>::pointer;
+        using const_pointer = typename std::allocator_traits<allocator_type>::const_pointer;
+
+        template <bool Const>
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = FlatHashTable::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<Const, const value_type&, value_type&>;
+            using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+            Iterator() = default;
+
+            // Allow conversion from iterator to const_iterator
+            template <bool C = Const, typename = std::enable_if_t<C>>
+            Iterator(const Iterator<false>& other) : table_(other.table_), idx_(other.idx_)
+            {
+            }
+
+            reference operator*() const { return table_->slots_[idx_]; }
+            pointer operator->() const { return &table_->slots_[idx_]; }
+
+            Iterator& operator++()
+            {
+                idx_ = table_->next_full(idx_ + 1);
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                auto ret = *this;
+                ++*this;
+                return ret;
+            }
+
+            friend bool operator==(const Iterator& a, const Iterator& b)
+            {
+                return a.idx_ == b.idx_;
+            }
+
+            friend bool operator!=(const Iterator& a, const Iterator& b) { return !(a == b); }
+
+        private:
+            friend class FlatHashTable;
+            template <bool>
+            friend class Iterator;
+            using Table = std::conditional_t<Const, const FlatHashTable, FlatHashTable>;
+
+            Iterator(Table* table, size_t idx) : table_(table), idx_(idx) { }
+
+            Table* table_ = nullptr;
+            size_t idx_ = 0;
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+    protected:
+        static constexpr bool is_transparent
+            = requires { typename Hash::is_transparent; } && requires {
+                  typename KeyEqual::is_transparent;
+              };
+
+        // If Hash and KeyEqual are not transparent, K cannot be deduced and defaults to key_type
+        template <typename K>
+        using key_arg = typename KeyArg<is_transparent>::template type<K, key_type>;
+
+    public:
+        FlatHashTable(size_t capacity = 0, const Hash& hash = Hash(),
+            const KeyEqual& eq = KeyEqual(), const Allocator& alloc = Allocator())
+            : hash_(hash)
+            , eq_(eq)
+            , alloc_(alloc)
+            , ctrl_alloc_(alloc)
+        {
+            if (capacity > 0) {
+                reserve(capacity);
+            }
+        }
+
+        FlatHashTable(const FlatHashTable& other)
+            : hash_(other.hash_)
+            , eq_(other.eq_)
+            , alloc_(std::allocator_traits<SlotAlloc>::select_on_container_copy_construction(
+                  other.alloc_))
+            , ctrl_alloc_(alloc_)
+        {
+            // Empty maps don't allocate
+            if (other.size_ == 0) {
+                return;
+            }
+            reserve(other.size());
+            for (const auto& v : other) {
+                const auto idx = find_first_non_full(hash_key(Policy::key(v)));
+                emplace_at(idx, hash_key(Policy::key(v)), v);
+            }
+        }
+
+        FlatHashTable(FlatHashTable&& other)
+            : hash_(std::move(other.hash_))
+            , eq_(std::move(other.eq_))
+            , alloc_(std::move(other.alloc_))
+            , ctrl_alloc_(alloc_)
+            , ctrl_(std::exchange(other.ctrl_, nullptr))
+            , slots_(std::exchange(other.slots_, nullptr))
+            , capacity_(std::exchange(other.capacity_, 0))
+            , size_(std::exchange(other.size_, 0))
+            , growth_left_(std::exchange(other.growth_left_, 0))
+        {
+        }
+
+        ~FlatHashTable()
+        {
+            destroy_slots();
+            deallocate();
+        }
+
+        FlatHashTable& operator=(FlatHashTable other)
+        {
+            swap(other);
+            return *this;
+        }
+
+        void swap(FlatHashTable& other)
+        {
+            using std::swap;
+            swap(hash_, other.hash_);
+            swap(eq_, other.eq_);
+            swap(alloc_, other.alloc_);
+            swap(ctrl_alloc_, other.ctrl_alloc_);
+            swap(ctrl_, other.ctrl_);
+            swap(slots_, other.slots_);
+            swap(capacity_, other.capacity_);
+            swap(size_, other.size_);
+            swap(growth_left_, other.growth_left_);
+        }
+
+        /* Selectors */
+        template <typename K = key_type>
+        iterator find(const key_arg<K>& key)
+        {
+            return iterator(this, find_index(key));
+        }
+
+        template <typename K = key_type>
+        const_iterator find(const key_arg<K>& key) const
+        {
+            return const_iterator(this, find_index(key));
+        }
+
+        template <typename K = key_type>
+        bool contains(const key_arg<K>& key) const
+        {
+            return find_index(key) != capacity_;
+        }
+
+        template <typename K = key_type>
+        size_type count(const key_arg<K>& key) const
+        {
+            return contains(key) ? 1 : 0;
+        }
+
+        size_type size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        size_type capacity() const { return capacity_; }
+        float load_factor() const
+        {
+            return capacity_ > 0 ? static_cast<float>(size_) / static_cast<float>(capacity_) : 0.0f;
+        }
+
+        hasher hash_function() const { return hash_; }
+        key_equal key_eq() const { return eq_; }
+        allocator_type get_allocator() const { return alloc_; }
+
+        /* Mutators */
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return emplace_key(Policy::key(value), value);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value)
+        {
+            return emplace_key(Policy::key(value), std::move(value));
+        }
+
+        template <typename InputIt>
+        void insert(InputIt first, InputIt last)
+        {
+            for (; first != last; ++first) {
+                insert(*first);
+            }
+        }
+
+        // This has to construct the value before it knows whether it will be inserted.
+        // For maps, prefer try_emplace.
+        template <typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args)
+        {
+            value_type value(std::forward<Args>(args)...);
+            return insert(std::move(value));
+        }
+
+        template <typename K = key_type>
+        size_type erase(const key_arg<K>& key)
+        {
+            const auto idx = find_index(key);
+            if (idx == capacity_) {
+                return 0;
+            }
+            erase_at(idx);
+            return 1;
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            assert(pos.idx_ < capacity_ && ctrl_[pos.idx_] >= 0);
+            erase_at(pos.idx_);
+            return iterator(this, next_full(pos.idx_ + 1));
+        }
+
+        iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+        void clear()
+        {
+            destroy_slots();
+            if (capacity_ > 0) {
+                std::memset(ctrl_, CtrlEmpty, capacity_);
+            }
+            size_ = 0;
+            growth_left_ = max_load(capacity_);
+        }
+
+        // Makes sure that `count` elements can be inserted without rehashing
+        void reserve(size_type count)
+        {
+            size_t cap = HashGroup::width;
+            while (max_load(cap) < count) {
+                cap *= 2;
+            }
+            if (cap > capacity_) {
+                rehash_to(cap);
+            }
+        }
+
+        /* Iterators */
+        iterator begin() { return iterator(this, next_full(0)); }
+        const_iterator begin() const { return const_iterator(this, next_full(0)); }
+        const_iterator cbegin() const { return begin(); }
+        iterator end() { return iterator(this, capacity_); }
+        const_iterator end() const { return const_iterator(this, capacity_); }
+        const_iterator cend() const { return end(); }
+
+    protected:
+        using SlotAlloc =
+            typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+        using CtrlAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<int8_t>;
+
+        static constexpr size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+
+        template <typename K>
+        uint64_t hash_key(const K& key) const
+        {
+            return mix_hash(static_cast<uint64_t>(hash_(key)));
+        }
+
+        static int8_t h2(uint64_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+        static size_t h1(uint64_t hash) { return static_cast<size_t>(hash >> 7); }
+
+        // Triangular probing over groups. Since the number of groups is a power of two, this visits
+        // every group exactly once.
+        struct ProbeSeq {
+            ProbeSeq(uint64_t hash, size_t capacity)
+                : mask(capacity / HashGroup::width - 1)
+                , group(h1(hash) & mask)
+            {
+            }
+
+            size_t offset() const { return group * HashGroup::width; }
+
+            void next()
+            {
+                ++step;
+                group = (group + step) & mask;
+            }
+
+            size_t mask;
+            size_t group;
+            size_t step = 0;
+        };
+
+        template <typename K>
+        size_t find_index(const K& key) const
+        {
+            if (capacity_ == 0) {
+                return 0;
+            }
+            const auto hash = hash_key(key);
+            return find_index(key, hash);
+        }
+
+        template <typename K>
+        size_t find_index(const K& key, uint64_t hash) const
+        {
+            ProbeSeq seq(hash, capacity_);
+            while (true) {
+                const HashGroup group(ctrl_ + seq.offset());
+                for (auto m = group.match(h2(hash)); m; m &= m - 1) {
+                    const auto idx = seq.offset() + std::countr_zero(m);
+                    if (eq_(Policy::key(slots_[idx]), key)) [[likely]] {
+                        return idx;
+                    }
+                }
+                if (group.match_empty()) [[likely]] {
+                    return capacity_;
+                }
+                seq.next();
+            }
+        }
+
+        size_t find_first_non_full(uint64_t hash) const
+        {
+            ProbeSeq seq(hash, capacity_);
+            while (true) {
+                const auto m = HashGroup(ctrl_ + seq.offset()).match_empty_or_deleted();
+                if (m) {
+                    return seq.offset() + std::countr_zero(m);
+                }
+                seq.next();
+            }
+        }
+
+        size_t next_full(size_t idx) const
+        {
+            while (idx < capacity_ && ctrl_[idx] < 0) {
+                ++idx;
+            }
+            return idx;
+        }
+
+        // Returns the index of the element with the given key or of a free slot for it.
+        // The bool is true if the slot is free (i.e. the key was not found).
+        template <typename K>
+        std::pair<size_t, bool> find_or_prepare_insert(const K& key, uint64_t hash)
+        {
+            if (capacity_ > 0) {
+                const auto idx = find_index(key, hash);
+                if (idx != capacity_) {
+                    return { idx, false };
+                }
+            }
+            auto idx = capacity_ > 0 ? find_first_non_full(hash) : 0;
+            if (capacity_ == 0 || (growth_left_ == 0 && ctrl_[idx] == CtrlEmpty)) {
+                grow();
+                idx = find_first_non_full(hash);
+            }
+            return { idx, true };
+        }
+
+        template <typename K, typename... Args>
+        std::pair<iterator, bool> emplace_key(const K& key, Args&&... args)
+        {
+            const auto hash = hash_key(key);
+            const auto [idx, inserted] = find_or_prepare_insert(key, hash);
+            if (inserted) {
+                emplace_at(idx, hash, std::forward<Args>(args)...);
+            }
+            return { iterator(this, idx), inserted };
+        }
+
+        template <typename... Args>
+        void emplace_at(size_t idx, uint64_t hash, Args&&... args)
+        {
+            assert(ctrl_[idx] < -1);
+            std::allocator_traits<SlotAlloc>::construct(
+                alloc_, slots_ + idx, std::forward<Args>(args)...);
+            growth_left_ -= ctrl_[idx] == CtrlEmpty ? 1 : 0;
+            ctrl_[idx] = h2(hash);
+            size_++;
+        }
+
+        void erase_at(size_t idx)
+        {
+            std::allocator_traits<SlotAlloc>::destroy(alloc_, slots_ + idx);
+            size_--;
+            const auto group_start = idx & ~(HashGroup::width - 1);
+            if (HashGroup(ctrl_ + group_start).match_empty()) {
+                ctrl_[idx] = CtrlEmpty;
+                growth_left_++;
+            } else {
+                ctrl_[idx] = CtrlDeleted;
+            }
+        }
+
+        void grow()
+        {
+            if (capacity_ == 0) {
+                rehash_to(HashGroup::width);
+            } else if (size_ <= max_load(capacity_) / 2) {
+                // Mostly tombstones, get rid of them
+                rehash_to(capacity_);
+            } else {
+                rehash_to(capacity_ * 2);
+            }
+        }
+
+        void rehash_to(size_t capacity)
+        {
+            assert(capacity % HashGroup::width == 0 && std::has_single_bit(capacity));
+            assert(max_load(capacity) >= size_);
+            const auto old_ctrl = ctrl_;
+            const auto old_slots = slots_;
+            const auto old_capacity = capacity_;
+
+            ctrl_ = std::allocator_traits<CtrlAlloc>::allocate(ctrl_alloc_, capacity);
+            slots_ = std::allocator_traits<SlotAlloc>::allocate(alloc_, capacity);
+            capacity_ = capacity;
+            std::memset(ctrl_, CtrlEmpty, capacity_);
+
+            for (size_t i = 0; i < old_capacity; ++i) {
+                if (old_ctrl[i] >= 0) {
+                    const auto hash = hash_key(Policy::key(old_slots[i]));
+                    const auto idx = find_first_non_full(hash);
+                    ctrl_[idx] = h2(hash);
+                    std::allocator_traits<SlotAlloc>::construct(
+                        alloc_, slots_ + idx, std::move(old_slots[i]));
+                    std::allocator_traits<SlotAlloc>::destroy(alloc_, old_slots + i);
+                }
+            }
+            growth_left_ = max_load(capacity_) - size_;
+
+            if (old_capacity > 0) {
+                std::allocator_traits<CtrlAlloc>::deallocate(ctrl_alloc_, old_ctrl, old_capacity);
+                std::allocator_traits<SlotAlloc>::deallocate(alloc_, old_slots, old_capacity);
+            }
+        }
+
+        void destroy_slots()
+        {
+            if constexpr (!std::is_trivially_destructible_v<value_type>) {
+                for (size_t i = 0; i < capacity_; ++i) {
+                    if (ctrl_[i] >= 0) {
+                        std::allocator_traits<SlotAlloc>::destroy(alloc_, slots_ + i);
+                    }
+                }
+            }
+        }
+
+        void deallocate()
+        {
+            if (capacity_ > 0) {
+                std::allocator_traits<CtrlAlloc>::deallocate(ctrl_alloc_, ctrl_, capacity_);
+                std::allocator_traits<SlotAlloc>::deallocate(alloc_, slots_, capacity_);
+            }
+        }
+
+        Hash hash_;
+        KeyEqual eq_;
+        SlotAlloc alloc_;
+        CtrlAlloc ctrl_alloc_;
+        int8_t* ctrl_ = nullptr;
+        value_type* slots_ = nullptr;
+        size_t capacity_ = 0;
+        size_t size_ = 0;
+        size_t growth_left_ = 0;
+    };
+}
+
+// Tries to be STL compatible (like std::unordered_map, but without the bucket interface)
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+    typename KeyEqual = std::equal_to<Key>,
+    typename Allocator = std::allocator<std::pair<const Key, T>>>
+class flat_hash_map
+    : public detail::FlatHashTable<detail::FlatMapPolicy<Key, T>, Hash, KeyEqual, Allocator> {
+    using Base = detail::FlatHashTable<detail::FlatMapPolicy<Key, T>, Hash, KeyEqual, Allocator>;
+    template <typename K>
+    using key_arg = typename Base::template key_arg<K>;
+
+public:
+    using mapped_type = T;
+    using typename Base::const_iterator;
+    using typename Base::iterator;
+    using typename Base::key_type;
+    using typename Base::value_type;
+
+    using Base::Base;
+    using Base::insert;
+
+    template <typename K = key_type>
+    mapped_type& at(const key_arg<K>& key)
+    {
+        const auto it = this->find(key);
+        if (it == this->end())
+            throw std::out_of_range("Could not find key in flat_hash_map");
+        return it->second;
+    }
+
+    template <typename K = key_type>
+    const mapped_type& at(const key_arg<K>& key) const
+    {
+        const auto it = this->find(key);
+        if (it == this->end())
+            throw std::out_of_range("Could not find key in flat_hash_map");
+        return it->second;
+    }
+
+    std::pair<iterator, bool> insert(const key_type& key, const mapped_type& value)
+    {
+        return try_emplace(key, value);
+    }
+
+    // Only constructs the value if the key is not present yet
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+    {
+        return this->emplace_key(key, std::piecewise_construct, std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+    {
+        return this->emplace_key(key, std::piecewise_construct,
+            std::forward_as_tuple(std::move(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& value)
+    {
+        auto res = try_emplace(key, std::forward<M>(value));
+        if (!res.second) {
+            res.first->second = std::forward<M>(value);
+        }
+        return res;
+    }
+
+    mapped_type& operator[](const key_type& key) { return try_emplace(key).first->second; }
+    mapped_type& operator[](key_type&& key) { return try_emplace(std::move(key)).first->second; }
+};
+
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>,
+    typename Allocator = std::allocator<Key>>
+class flat_hash_set
+    : public detail::FlatHashTable<detail::FlatSetPolicy<Key>, Hash, KeyEqual, Allocator> {
+    using Base = detail::FlatHashTable<detail::FlatSetPolicy<Key>, Hash, KeyEqual, Allocator>;
+
+public:
+    // Elements of a set must not be modified
+    using iterator = typename Base::const_iterator;
+    using const_iterator = typename Base::const_iterator;
+
+    using Base::Base;
+
+    iterator begin() const { return Base::begin(); }
+    iterator end() const { return Base::end(); }
+
+    template <typename K = Key>
+    iterator find(const typename Base::template key_arg<K>& key) const
+    {
+        return Base::find(key);
+    }
+
+    std::pair<iterator, bool> insert(const Key& value)
+    {
+        const auto res = Base::insert(value);
+        return { res.first, res.second };
+    }
+
+    std::pair<iterator, bool> insert(Key&& value)
+    {
+        const auto res = Base::insert(std::move(value));
+        return { res.first, res.second };
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        Base::insert(first, last);
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        const auto res = Base::emplace(std::forward<Args>(args)...);
+        return { res.first, res.second };
+    }
+
+    using Base::erase;
+
+    iterator erase(const_iterator pos) { return Base::erase(pos); }
+};
+
+}
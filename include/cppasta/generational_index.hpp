@@ -17,26 +17,26 @@ concept GenerationalIndex = requires(T id) {
 // CRTP Base
 template <typename Derived>
 struct GenerationalIdBase {
-    static Derived max() { return Derived(-1, -1); }
+    static constexpr Derived max() { return Derived(-1, -1); }
 
-    Derived next_generation() const
+    constexpr Derived next_generation() const
     {
         const auto g = (derived().gen() + 1) & max().gen();
         return Derived(derived().idx(), g == 0 ? 1 : g);
     }
 
-    bool valid() const { return derived().gen() != 0; }
+    constexpr bool valid() const { return derived().gen() != 0; }
 
-    explicit operator bool() const { return valid(); }
+    constexpr explicit operator bool() const { return valid(); }
 
-    const Derived& derived() const { return static_cast<const Derived&>(*this); }
+    constexpr const Derived& derived() const { return static_cast<const Derived&>(*this); }
 
-    friend bool operator==(const Derived& a, const Derived& b)
+    friend constexpr bool operator==(const Derived& a, const Derived& b)
     {
         return a.idx() == b.idx() && a.gen() == b.gen();
     }
 
-    friend bool operator!=(const Derived& a, const Derived& b) { return !(a == b); }
+    friend constexpr bool operator!=(const Derived& a, const Derived& b) { return !(a == b); }
 };
 
 template <typename Tag = void, typename BaseInt = uint64_t,
@@ -47,12 +47,16 @@ public:
     using IndexType = BaseInt;
     using GenerationType = BaseInt;
 
-    BitFieldId() : index(0), generation(0) { }
+    constexpr BitFieldId() : index(0), generation(0) { }
 
-    BitFieldId(IndexType i, GenerationType g) : index(i & IdxMask), generation(g & GenMask) { }
+    constexpr BitFieldId(IndexType i, GenerationType g)
+        : index(i & IdxMask)
+        , generation(g & GenMask)
+    {
+    }
 
-    IndexType idx() const { return index; }
-    GenerationType gen() const { return generation; }
+    constexpr IndexType idx() const { return index; }
+    constexpr GenerationType gen() const { return generation; }
 
 private:
     static constexpr auto IdxBits = sizeof(BaseInt) * 8 - GenBits;
@@ -71,13 +75,13 @@ public:
     using IndexType = BaseInt;
     using GenerationType = BaseInt;
 
-    BitMaskId() : value(0) { }
+    constexpr BitMaskId() : value(0) { }
 
     // The shift discards out-of-range bits, so that g will wrap around nicely
-    BitMaskId(IndexType i, GenerationType g) : value((g << IdxBits) | (i & IdxMask)) { }
+    constexpr BitMaskId(IndexType i, GenerationType g) : value((g << IdxBits) | (i & IdxMask)) { }
 
-    IndexType idx() const { return value & IdxMask; }
-    GenerationType gen() const { return value >> IdxBits; }
+    constexpr IndexType idx() const { return value & IdxMask; }
+    constexpr GenerationType gen() const { return value >> IdxBits; }
 
 private:
     static constexpr auto IdxBits = sizeof(BaseInt) * 8 - GenBits;
@@ -97,11 +101,11 @@ public:
     using IndexType = IdxInt;
     using GenerationType = GenInt;
 
-    CompositeId() : index(0), generation(0) { }
-    CompositeId(IndexType i, GenerationType g) : index(i), generation(g) { }
+    constexpr CompositeId() : index(0), generation(0) { }
+    constexpr CompositeId(IndexType i, GenerationType g) : index(i), generation(g) { }
 
-    IndexType idx() const { return index; }
-    GenerationType gen() const { return generation; }
+    constexpr IndexType idx() const { return index; }
+    constexpr GenerationType gen() const { return generation; }
 
 private:
     IndexType index;
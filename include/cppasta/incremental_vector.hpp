@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/* IncrementalVector
+
+A vector (only the parts DenseSlotMap needs) that doesn't move all its elements when it grows.
+Instead a new buffer is allocated and every following push_back/emplace_back/pop_back moves
+MigrationStep elements from the old buffer to the new one. So growing costs as much as an allocation
+and no single operation takes longer than moving a handful of elements, which matters if you care
+about worst-case latency more than throughput.
+
+While elements are being migrated, operator[] has to check which buffer an element is in, so
+random access is a little slower and there is no data() (the elements are not contiguous).
+emplace_back doubles the capacity, so a migration started by it is always done before the next
+one would start. But reserve() while a migration is running (e.g. from DenseSlotMap with a growth
+factor below 2) has to finish it first, which moves all remaining elements at once (O(n)), so
+don't do that if latency matters.
+Both buffers are alive during the migration, so peak memory usage is 3x the old capacity (just
+like for std::vector, but for longer).
+
+Use it as DataStorage and MetaStorage of DenseSlotMap to make its growth incremental.
+*/
+
+namespace pasta {
+
+template <typename T>
+class IncrementalVector {
+public:
+    using value_type = T;
+
+    static constexpr size_t MigrationStep = 64;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using Vector = std::conditional_t<Const, const IncrementalVector, IncrementalVector>;
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        Iterator() = default;
+        Iterator(Vector* vec, size_t idx) : vec_(vec), idx_(idx) { }
+
+        reference operator*() const { return (*vec_)[idx_]; }
+        pointer operator->() const { return &(*vec_)[idx_]; }
+
+        Iterator& operator++()
+        {
+            idx_++;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto tmp = *this;
+            idx_++;
+            return tmp;
+        }
+
+        bool operator==(const Iterator& other) const { return idx_ == other.idx_; }
+
+    private:
+        Vector* vec_ = nullptr;
+        size_t idx_ = 0;
+    };
+
+    IncrementalVector() = default;
+
+    ~IncrementalVector()
+    {
+        for (size_t i = 0; i < size_; ++i) {
+            slot(i)->~T();
+        }
+        dealloc(data_);
+        dealloc(old_data_);
+    }
+
+    IncrementalVector(const IncrementalVector&) = delete;
+    IncrementalVector& operator=(const IncrementalVector&) = delete;
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    // Finishes a running migration before starting a new one, which is O(n)!
+    void reserve(size_t capacity)
+    {
+        if (capacity <= capacity_) {
+            return;
+        }
+        finish_migration();
+        old_data_ = data_;
+        old_end_ = size_;
+        migrated_ = 0;
+        data_ = alloc(capacity);
+        capacity_ = capacity;
+        if (old_end_ == 0) {
+            finish_migration();
+        }
+    }
+
+    bool migrating() const { return old_data_ != nullptr; }
+
+    void finish_migration() { migrate(old_end_); }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_) {
+            // args might refer to an element, which might be moved if a migration is still running
+            T value(std::forward<Args>(args)...);
+            reserve(capacity_ > 0 ? capacity_ * 2 : 8);
+            return emplace_back_unchecked(std::move(value));
+        }
+        return emplace_back_unchecked(std::forward<Args>(args)...);
+    }
+
+    void pop_back()
+    {
+        assert(size_ > 0);
+        const auto idx = size_ - 1;
+        slot(idx)->~T();
+        if (idx >= migrated_ && idx < old_end_) {
+            // size_ >= old_end_ always, so this is the last element in the old buffer
+            old_end_ = idx;
+        }
+        size_--;
+        migrate(migrated_ + MigrationStep);
+    }
+
+    T& operator[](size_t idx)
+    {
+        assert(idx < size_);
+        return *slot(idx);
+    }
+
+    const T& operator[](size_t idx) const
+    {
+        assert(idx < size_);
+        return *slot(idx);
+    }
+
+    T& back() { return (*this)[size_ - 1]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+
+    auto begin() { return Iterator<false>(this, 0); }
+    auto begin() const { return Iterator<true>(this, 0); }
+    auto end() { return Iterator<false>(this, size_); }
+    auto end() const { return Iterator<true>(this, size_); }
+
+private:
+    static T* alloc(size_t num)
+    {
+        return static_cast<T*>(::operator new(num * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    static void dealloc(T* data)
+    {
+        if (data) {
+            operator delete(data, std::align_val_t(alignof(T)));
+        }
+    }
+
+    // [migrated_, old_end_) are still in old_data_, everything else is in data_
+    T* slot(size_t idx) const
+    {
+        return idx >= migrated_ && idx < old_end_ ? old_data_ + idx : data_ + idx;
+    }
+
+    template <typename... Args>
+    T& emplace_back_unchecked(Args&&... args)
+    {
+        // size_ >= old_end_, so this is always in the new buffer
+        auto ptr = new (data_ + size_) T(std::forward<Args>(args)...);
+        size_++;
+        // After constructing, because args might refer to an element that will be moved
+        migrate(migrated_ + MigrationStep);
+        return *ptr;
+    }
+
+    // Moves the elements up to end to the new buffer
+    void migrate(size_t end)
+    {
+        if (!old_data_) {
+            return;
+        }
+        end = end < old_end_ ? end : old_end_;
+        for (; migrated_ < end; ++migrated_) {
+            new (data_ + migrated_) T(std::move(old_data_[migrated_]));
+            old_data_[migrated_].~T();
+        }
+        if (migrated_ == old_end_) {
+            dealloc(old_data_);
+            old_data_ = nullptr;
+            old_end_ = 0;
+            migrated_ = 0;
+        }
+    }
+
+    T* data_ = nullptr;
+    T* old_data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    size_t migrated_ = 0;
+    size_t old_end_ = 0;
+};
+
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "generational_index.hpp"
+
+/* IndexedHeap
+
+A priority queue that supports changing the priority of (and removing) elements that are already
+in the queue, i.e. decrease-key for Dijkstra/A* or rescheduling. Elements are generational keys
+(from a SlotMap or DenseSlotMap for example) and the position of every key in the heap is kept
+in an array indexed by key.idx(), so finding an element is a single lookup.
+
+The heap is 4-ary instead of binary. It is only half as deep and the 4 children of a node are
+adjacent in memory (usually in the same cache line), so it is faster in practice, even though
+sifting down needs more comparisons per level.
+
+With the default Compare (std::less) top() is the element with the smallest priority.
+Every key index can be in the heap only once (which is always true for live keys of a single map).
+*/
+
+namespace pasta {
+
+template <GenerationalIndex Key, typename Priority, typename Compare = std::less<Priority>,
+    size_t Arity = 4>
+class IndexedHeap {
+    static_assert(Arity >= 2);
+
+public:
+    struct Entry {
+        Key key;
+        Priority priority;
+    };
+
+    IndexedHeap(const Compare& compare = Compare()) : compare_(compare) { }
+
+    // Preallocates heap storage for `size` elements and position storage for key indices up to
+    // `max_index` (exclusive)
+    void reserve(size_t size, size_t max_index)
+    {
+        heap_.reserve(size);
+        if (positions_.size() < max_index) {
+            positions_.resize(max_index, NoPosition);
+        }
+    }
+
+    void push(Key key, Priority priority)
+    {
+        const auto idx = static_cast<size_t>(key.idx());
+        if (idx >= positions_.size()) {
+            positions_.resize(idx + 1, NoPosition);
+        }
+        assert(positions_[idx] == NoPosition && "Key index already in heap");
+        heap_.push_back(Entry { key, std::move(priority) });
+        sift_up(heap_.size() - 1);
+    }
+
+    const Entry& top() const
+    {
+        assert(!empty());
+        return heap_.front();
+    }
+
+    Entry pop()
+    {
+        assert(!empty());
+        // Not remove_at(0), which would compare against the moved-from root
+        positions_[heap_.front().key.idx()] = NoPosition;
+        auto entry = std::move(heap_.front());
+        if (heap_.size() > 1) {
+            place(0, std::move(heap_.back()));
+            heap_.pop_back();
+            sift_down(0);
+        } else {
+            heap_.pop_back();
+        }
+        return entry;
+    }
+
+    // Returns false if the key is not in the heap
+    bool update(Key key, Priority priority)
+    {
+        const auto pos = position(key);
+        if (pos == NoPosition) {
+            return false;
+        }
+        const auto up = compare_(priority, heap_[pos].priority);
+        heap_[pos].priority = std::move(priority);
+        if (up) {
+            sift_up(pos);
+        } else {
+            sift_down(pos);
+        }
+        return true;
+    }
+
+    // Pushes the key if it is not in the heap yet or updates its priority otherwise.
+    // Returns true if the key was pushed.
+    bool push_or_update(Key key, Priority priority)
+    {
+        if (contains(key)) {
+            update(key, std::move(priority));
+            return false;
+        }
+        push(key, std::move(priority));
+        return true;
+    }
+
+    bool erase(Key key)
+    {
+        const auto pos = position(key);
+        if (pos == NoPosition) {
+            return false;
+        }
+        remove_at(pos);
+        return true;
+    }
+
+    bool contains(Key key) const { return position(key) != NoPosition; }
+
+    const Priority* find(Key key) const
+    {
+        const auto pos = position(key);
+        return pos != NoPosition ? &heap_[pos].priority : nullptr;
+    }
+
+    size_t size() const { return heap_.size(); }
+    bool empty() const { return heap_.empty(); }
+
+    void clear()
+    {
+        for (const auto& entry : heap_) {
+            positions_[entry.key.idx()] = NoPosition;
+        }
+        heap_.clear();
+    }
+
+    // In heap order, mostly for debugging
+    const std::vector<Entry>& entries() const { return heap_; }
+
+private:
+    static constexpr uint32_t NoPosition = std::numeric_limits<uint32_t>::max();
+
+    uint32_t position(Key key) const
+    {
+        const auto idx = static_cast<size_t>(key.idx());
+        if (idx >= positions_.size()) {
+            return NoPosition;
+        }
+        const auto pos = positions_[idx];
+        return pos != NoPosition && heap_[pos].key == key ? pos : NoPosition;
+    }
+
+    void place(size_t pos, Entry&& entry)
+    {
+        positions_[entry.key.idx()] = static_cast<uint32_t>(pos);
+        heap_[pos] = std::move(entry);
+    }
+
+    void remove_at(size_t pos)
+    {
+        positions_[heap_[pos].key.idx()] = NoPosition;
+        const auto last = heap_.size() - 1;
+        if (pos != last) {
+            const auto up = compare_(heap_[last].priority, heap_[pos].priority);
+            place(pos, std::move(heap_[last]));
+            heap_.pop_back();
+            if (up) {
+                sift_up(pos);
+            } else {
+                sift_down(pos);
+            }
+        } else {
+            heap_.pop_back();
+        }
+    }
+
+    // Both sift functions move a hole instead of swapping
+    void sift_up(size_t pos)
+    {
+        auto entry = std::move(heap_[pos]);
+        while (pos > 0) {
+            const auto parent = (pos - 1) / Arity;
+            if (!compare_(entry.priority, heap_[parent].priority)) {
+                break;
+            }
+            place(pos, std::move(heap_[parent]));
+            pos = parent;
+        }
+        place(pos, std::move(entry));
+    }
+
+    void sift_down(size_t pos)
+    {
+        auto entry = std::move(heap_[pos]);
+        const auto size = heap_.size();
+        while (true) {
+            const auto first_child = pos * Arity + 1;
+            if (first_child >= size) {
+                break;
+            }
+            const auto last_child = std::min(first_child + Arity, size);
+            auto best = first_child;
+            for (auto c = first_child + 1; c < last_child; ++c) {
+                if (compare_(heap_[c].priority, heap_[best].priority)) {
+                    best = c;
+                }
+            }
+            if (!compare_(heap_[best].priority, entry.priority)) {
+                break;
+            }
+            place(pos, std::move(heap_[best]));
+            pos = best;
+        }
+        place(pos, std::move(entry));
+    }
+
+    std::vector<Entry> heap_;
+    std::vector<uint32_t> positions_; // key.idx() -> index into heap_
+    Compare compare_;
+};
+
+}
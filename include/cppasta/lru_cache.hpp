@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "dense_slot_map.hpp"
+#include "flat_hash_map.hpp"
+
+/* LruCache / ClockCache
+
+Fixed capacity caches that evict the least recently used entry (LruCache) or an approximation of
+it (ClockCache) if they are full.
+
+The entries live in a DenseSlotMap and a flat_hash_map maps the cache keys to slot map keys. The
+constructor allocates both: the DenseSlotMap reserves room for `capacity` entries and never grows,
+and the index reserves room for twice the capacity, so it is never more than half full and never
+has to double its capacity. get, peek, contains and erase never allocate. put only allocates when
+the index is rebuilt: evictions leave tombstones in it and once they fill up the free space, it is
+rebuilt at the same size, which allocates a new table. That happens at most once every `capacity`
+evictions (usually much less often, because most erasures don't leave a tombstone). Copying K and
+V into the cache might allocate of course, which is up to them.
+
+LruCache keeps a doubly linked list of entries in order of their last use. The links are slot map
+keys, which are stable even though the DenseSlotMap moves entries around on removal.
+Every hit has to update a few links in (likely) different cache lines, which is why there is
+ClockCache (also called second chance). Every entry has a referenced flag that is set on access.
+To evict, a clock hand moves over the entries, clearing the flags, until it finds an unreferenced
+one. This is very cheap on hits and the hand iterates over the dense array, so eviction is cheap
+as well.
+
+Pointers returned by get/peek/put are invalidated by the next modification of the cache.
+*/
+
+namespace pasta {
+
+template <typename K, typename V, typename Hash = std::hash<K>,
+    typename KeyEqual = std::equal_to<K>>
+class LruCache {
+public:
+    using key_type = K;
+    using mapped_type = V;
+
+    LruCache(size_t capacity) : entries_(capacity), capacity_(capacity)
+    {
+        assert(capacity > 0);
+        // See above, at most half full means it's only ever rebuilt at the same size
+        index_.reserve(2 * capacity);
+    }
+
+    // Returns nullptr if the key is not in the cache, otherwise marks the entry as most recently
+    // used.
+    V* get(const K& key)
+    {
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        touch(it->second);
+        return &entries_.get(it->second)->value;
+    }
+
+    // Like get, but does not update recency
+    const V* peek(const K& key) const
+    {
+        const auto it = index_.find(key);
+        return it != index_.end() ? &entries_.get(it->second)->value : nullptr;
+    }
+
+    bool contains(const K& key) const { return index_.contains(key); }
+
+    // Inserts or overwrites the value for key and makes it the most recently used entry.
+    // If the cache is full, the least recently used entry is evicted.
+    V& put(const K& key, V value)
+    {
+        const auto it = index_.find(key);
+        if (it != index_.end()) {
+            touch(it->second);
+            auto& v = entries_.get(it->second)->value;
+            v = std::move(value);
+            return v;
+        }
+        if (entries_.size() == capacity_) {
+            evict();
+        }
+        const auto slot = entries_.insert(Entry { key, std::move(value), SlotKey(), head_ });
+        link_front(slot);
+        index_.insert(key, slot);
+        return entries_.get(slot)->value;
+    }
+
+    bool erase(const K& key)
+    {
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        const auto slot = it->second;
+        index_.erase(it);
+        unlink(slot);
+        entries_.remove(slot);
+        return true;
+    }
+
+    // Returns the key of the entry that would be evicted next
+    const K* lru() const { return tail_ ? &entries_.get(tail_)->key : nullptr; }
+
+    void clear()
+    {
+        while (tail_) {
+            erase(entries_.get(tail_)->key);
+        }
+    }
+
+    size_t size() const { return entries_.size(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    using SlotKey = CompositeId<struct LruCacheTag>;
+
+    struct Entry {
+        K key;
+        V value;
+        SlotKey prev; // towards the front (more recently used)
+        SlotKey next;
+    };
+
+    Entry& entry(SlotKey slot) { return *entries_.get(slot); }
+
+    void link_front(SlotKey slot)
+    {
+        auto& e = entry(slot);
+        e.prev = SlotKey();
+        e.next = head_;
+        if (head_) {
+            entry(head_).prev = slot;
+        } else {
+            tail_ = slot;
+        }
+        head_ = slot;
+    }
+
+    void unlink(SlotKey slot)
+    {
+        auto& e = entry(slot);
+        if (e.prev) {
+            entry(e.prev).next = e.next;
+        } else {
+            head_ = e.next;
+        }
+        if (e.next) {
+            entry(e.next).prev = e.prev;
+        } else {
+            tail_ = e.prev;
+        }
+    }
+
+    void touch(SlotKey slot)
+    {
+        if (slot != head_) {
+            unlink(slot);
+            link_front(slot);
+        }
+    }
+
+    void evict()
+    {
+        assert(tail_);
+        erase(entry(tail_).key);
+    }
+
+    DenseSlotMap<Entry, std::vector, std::vector, SlotKey> entries_;
+    flat_hash_map<K, SlotKey, Hash, KeyEqual> index_;
+    SlotKey head_;
+    SlotKey tail_;
+    size_t capacity_;
+};
+
+template <typename K, typename V, typename Hash = std::hash<K>,
+    typename KeyEqual = std::equal_to<K>>
+class ClockCache {
+public:
+    using key_type = K;
+    using mapped_type = V;
+
+    ClockCache(size_t capacity) : entries_(capacity), capacity_(capacity)
+    {
+        assert(capacity > 0);
+        // See above, at most half full means it's only ever rebuilt at the same size
+        index_.reserve(2 * capacity);
+    }
+
+    V* get(const K& key)
+    {
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        auto e = entries_.get(it->second);
+        e->referenced = true;
+        return &e->value;
+    }
+
+    const V* peek(const K& key) const
+    {
+        const auto it = index_.find(key);
+        return it != index_.end() ? &entries_.get(it->second)->value : nullptr;
+    }
+
+    bool contains(const K& key) const { return index_.contains(key); }
+
+    // New entries start out unreferenced, so entries that are never accessed after insertion are
+    // evicted first.
+    V& put(const K& key, V value)
+    {
+        const auto it = index_.find(key);
+        if (it != index_.end()) {
+            auto e = entries_.get(it->second);
+            e->referenced = true;
+            e->value = std::move(value);
+            return e->value;
+        }
+        if (entries_.size() == capacity_) {
+            evict();
+        }
+        const auto slot = entries_.insert(Entry { key, std::move(value), false });
+        index_.insert(key, slot);
+        return entries_.get(slot)->value;
+    }
+
+    bool erase(const K& key)
+    {
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        const auto slot = it->second;
+        index_.erase(it);
+        entries_.remove(slot);
+        return true;
+    }
+
+    void clear()
+    {
+        while (entries_.size() > 0) {
+            erase(entries_.begin()->key);
+        }
+        hand_ = 0;
+    }
+
+    size_t size() const { return entries_.size(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    using SlotKey = CompositeId<struct ClockCacheTag>;
+
+    struct Entry {
+        K key;
+        V value;
+        bool referenced;
+    };
+
+    void evict()
+    {
+        assert(entries_.size() > 0);
+        // Terminates after at most one full revolution, because we clear the flags on the way
+        while (true) {
+            if (hand_ >= entries_.size()) {
+                hand_ = 0;
+            }
+            auto& e = *(entries_.begin() + hand_);
+            if (!e.referenced) {
+                // The last element is moved into this position, so the hand stays where it is
+                erase(e.key);
+                return;
+            }
+            e.referenced = false;
+            hand_++;
+        }
+    }
+
+    DenseSlotMap<Entry, std::vector, std::vector, SlotKey> entries_;
+    flat_hash_map<K, SlotKey, Hash, KeyEqual> index_;
+    size_t hand_ = 0;
+    size_t capacity_;
+};
+
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+/* Parallel algorithms
+
+Data parallel for_each, transform_into, transform_reduce/reduce and inclusive/exclusive scans on a
+ThreadPool (getThreadPool() by default).
+
+They work on anything that has size() and operator[] (std::vector, std::span, RangeView, ...) or
+that is a sized random access range (e.g. DenseSlotMap).
+
+The input is split into chunks of grain_size elements (the last one might be smaller). Chunk
+boundaries only depend on the size of the input and grain_size, never on the number of threads,
+and the partial results of the chunks are combined in order on the calling thread. So reductions
+and scans give the same result on every machine (even for non-associative operations like
+floating point addition), but that result might differ from a serial std::accumulate.
+Choose grain_size so that a single chunk is at least a few microseconds of work.
+*/
+
+namespace pasta::parallel {
+
+constexpr size_t DefaultGrainSize = 4096;
+
+namespace detail {
+    template <typename Range>
+    concept Indexable = requires(Range& r, size_t i) {
+        r[i];
+        { r.size() } -> std::convertible_to<size_t>;
+    };
+
+    template <typename Range>
+    concept ParallelRange = Indexable<Range>
+        || (std::ranges::random_access_range<Range> && std::ranges::sized_range<Range>);
+
+    template <ParallelRange Range>
+    size_t size(Range& r)
+    {
+        if constexpr (Indexable<Range>) {
+            return static_cast<size_t>(r.size());
+        } else {
+            return static_cast<size_t>(std::ranges::size(r));
+        }
+    }
+
+    template <ParallelRange Range>
+    decltype(auto) at(Range& r, size_t i)
+    {
+        if constexpr (Indexable<Range>) {
+            return r[i];
+        } else {
+            return std::ranges::begin(r)[static_cast<std::ptrdiff_t>(i)];
+        }
+    }
+
+    inline size_t num_chunks(size_t size, size_t grain_size)
+    {
+        assert(grain_size > 0);
+        return (size + grain_size - 1) / grain_size;
+    }
+
+    // Calls func(begin, end) for every chunk
+    template <typename Func>
+    void for_each_chunk(size_t size, size_t grain_size, ThreadPool& pool, Func&& func)
+    {
+        pool.run(num_chunks(size, grain_size), [&](size_t chunk) {
+            const auto begin = chunk * grain_size;
+            func(begin, std::min(begin + grain_size, size));
+        });
+    }
+
+    // Computes the reduction of every chunk
+    template <typename T, typename Range, typename ReduceOp, typename TransformOp>
+    std::vector<std::optional<T>> reduce_chunks(Range& range, ReduceOp& reduce_op,
+        TransformOp& transform_op, size_t grain_size, ThreadPool& pool)
+    {
+        const auto n = size(range);
+        std::vector<std::optional<T>> partials(num_chunks(n, grain_size));
+        for_each_chunk(n, grain_size, pool, [&](size_t begin, size_t end) {
+            T acc = transform_op(at(range, begin));
+            for (auto i = begin + 1; i < end; ++i) {
+                acc = reduce_op(std::move(acc), transform_op(at(range, i)));
+            }
+            partials[begin / grain_size] = std::move(acc);
+        });
+        return partials;
+    }
+
+    struct Identity {
+        template <typename T>
+        T&& operator()(T&& v) const
+        {
+            return std::forward<T>(v);
+        }
+    };
+}
+
+// Calls func(elem) for every element
+template <detail::ParallelRange Range, typename Func>
+void for_each(Range& range, Func&& func, size_t grain_size = DefaultGrainSize,
+    ThreadPool& pool = getThreadPool())
+{
+    detail::for_each_chunk(detail::size(range), grain_size, pool, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            func(detail::at(range, i));
+        }
+    });
+}
+
+// out[i] = func(in[i]). out must already have the same size as in.
+template <detail::ParallelRange In, detail::ParallelRange Out, typename Func>
+void transform_into(const In& in, Out& out, Func&& func, size_t grain_size = DefaultGrainSize,
+    ThreadPool& pool = getThreadPool())
+{
+    assert(detail::size(out) == detail::size(in));
+    detail::for_each_chunk(detail::size(in), grain_size, pool, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            detail::at(out, i) = func(detail::at(in, i));
+        }
+    });
+}
+
+// Returns reduce_op(...reduce_op(reduce_op(init, transform_op(in[0])), transform_op(in[1]))...),
+// but grouped by chunks (see above).
+template <detail::ParallelRange Range, typename T, typename ReduceOp, typename TransformOp>
+T transform_reduce(const Range& range, T init, ReduceOp&& reduce_op, TransformOp&& transform_op,
+    size_t grain_size = DefaultGrainSize, ThreadPool& pool = getThreadPool())
+{
+    auto partials = detail::reduce_chunks<T>(range, reduce_op, transform_op, grain_size, pool);
+    for (auto& partial : partials) {
+        init = reduce_op(std::move(init), std::move(*partial));
+    }
+    return init;
+}
+
+template <detail::ParallelRange Range, typename T, typename ReduceOp = std::plus<>>
+T reduce(const Range& range, T init, ReduceOp&& reduce_op = ReduceOp(),
+    size_t grain_size = DefaultGrainSize, ThreadPool& pool = getThreadPool())
+{
+    return transform_reduce(range, std::move(init), std::forward<ReduceOp>(reduce_op),
+        detail::Identity(), grain_size, pool);
+}
+
+// out[i] = in[0] op in[1] op ... op in[i]. out must already have the same size as in and may be
+// the same range.
+template <detail::ParallelRange In, detail::ParallelRange Out, typename BinaryOp = std::plus<>>
+void inclusive_scan(const In& in, Out& out, BinaryOp&& op = BinaryOp(),
+    size_t grain_size = DefaultGrainSize, ThreadPool& pool = getThreadPool())
+{
+    using T = std::remove_cvref_t<decltype(detail::at(out, 0))>;
+    const auto n = detail::size(in);
+    assert(detail::size(out) == n);
+    if (n == 0) {
+        return;
+    }
+    // First pass: sum of every chunk, then the offsets are the (serial) exclusive scan of those
+    detail::Identity identity;
+    const auto totals = detail::reduce_chunks<T>(in, op, identity, grain_size, pool);
+    std::vector<std::optional<T>> offsets(totals.size());
+    for (size_t c = 1; c < totals.size(); ++c) {
+        offsets[c] = offsets[c - 1] ? op(*offsets[c - 1], *totals[c - 1]) : *totals[c - 1];
+    }
+    // Second pass: scan every chunk starting from its offset
+    detail::for_each_chunk(n, grain_size, pool, [&](size_t begin, size_t end) {
+        const auto& offset = offsets[begin / grain_size];
+        T acc = offset ? op(*offset, detail::at(in, begin)) : T(detail::at(in, begin));
+        detail::at(out, begin) = acc;
+        for (auto i = begin + 1; i < end; ++i) {
+            acc = op(std::move(acc), detail::at(in, i));
+            detail::at(out, i) = acc;
+        }
+    });
+}
+
+// out[0] = init, out[i] = init op in[0] op ... op in[i - 1]. out must already have the same size
+// as in and may be the same range.
+template <detail::ParallelRange In, detail::ParallelRange Out, typename T,
+    typename BinaryOp = std::plus<>>
+void exclusive_scan(const In& in, Out& out, T init, BinaryOp&& op = BinaryOp(),
+    size_t grain_size = DefaultGrainSize, ThreadPool& pool = getThreadPool())
+{
+    const auto n = detail::size(in);
+    assert(detail::size(out) == n);
+    if (n == 0) {
+        return;
+    }
+    detail::Identity identity;
+    const auto totals = detail::reduce_chunks<T>(in, op, identity, grain_size, pool);
+    std::vector<T> offsets;
+    offsets.reserve(totals.size());
+    offsets.push_back(std::move(init));
+    for (size_t c = 1; c < totals.size(); ++c) {
+        offsets.push_back(op(offsets.back(), *totals[c - 1]));
+    }
+    detail::for_each_chunk(n, grain_size, pool, [&](size_t begin, size_t end) {
+        T acc = offsets[begin / grain_size];
+        for (auto i = begin; i < end; ++i) {
+            // Read first, in case in and out are the same range
+            auto v = detail::at(in, i);
+            detail::at(out, i) = acc;
+            acc = op(std::move(acc), std::move(v));
+        }
+    });
+}
+
+}
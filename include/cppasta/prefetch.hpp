@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+namespace pasta {
+
+// How many elements batched lookups (e.g. SlotMap::find_many) prefetch ahead. A cache miss takes
+// about as long as a handful of lookups that hit, so this is enough to hide most of it, without
+// prefetching so far ahead that the lines are evicted again before they are used.
+constexpr size_t PrefetchDistance = 8;
+
+// Only a hint, addr may be anything (even invalid)
+inline void prefetch(const void* addr)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(addr);
+#elif defined(_MSC_VER)
+    _mm_prefetch(static_cast<const char*>(addr), _MM_HINT_T0);
+#else
+    (void)addr;
+#endif
+}
+
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+/* Radix sort
+
+LSD radix sort with 8-bit digits for integer keys (or anything that has an integer sort key, like
+generational keys by idx(), Morton codes or render sort keys).
+
+radix_sort(keys) sorts integers, radix_sort(keys, values) additionally applies the same
+permutation to values and radix_sort_by(items, key_func) sorts arbitrary items by an integer key.
+All of them are stable. parallel::radix_sort* do the same on a ThreadPool.
+
+The histograms for all digits are computed in a single pass first and digits for which all keys
+fall into the same bucket (e.g. the upper bytes of small indices) are skipped entirely. Every
+other digit is one pass that scatters all elements into a temporary buffer of the same size, so
+the items have to be default constructible and movable.
+Small inputs are sorted with std::sort (or insertion sort if stability matters) instead.
+*/
+
+namespace pasta {
+
+namespace detail {
+    template <typename T>
+    concept RadixKey = std::integral<T> && !std::same_as<T, bool>;
+
+    // Maps signed keys to unsigned keys with the same order
+    template <RadixKey K>
+    auto to_radix_key(K key)
+    {
+        using U = std::make_unsigned_t<K>;
+        if constexpr (std::is_signed_v<K>) {
+            return static_cast<U>(static_cast<U>(key) ^ (U(1) << (sizeof(U) * 8 - 1)));
+        } else {
+            return static_cast<U>(key);
+        }
+    }
+
+    struct NoPayload { };
+
+    struct IdentityKey {
+        template <typename T>
+        T operator()(const T& v) const
+        {
+            return v;
+        }
+    };
+
+    template <typename T, typename KeyFunc>
+    using RadixKeyType = decltype(to_radix_key(std::declval<KeyFunc&>()(std::declval<const T&>())));
+
+    constexpr size_t RadixBuckets = 256;
+
+    template <typename U>
+    size_t digit(U key, size_t d)
+    {
+        return static_cast<size_t>((key >> (d * 8)) & 0xff);
+    }
+
+    // Sorts items and values (if there are any) by key_func(item) with the same permutation
+    template <typename T, typename V, typename KeyFunc>
+    class RadixSorter {
+    public:
+        using U = RadixKeyType<T, KeyFunc>;
+        static constexpr size_t NumDigits = sizeof(U);
+        static constexpr bool HasValues = !std::is_same_v<V, NoPayload>;
+        using Histogram = std::array<std::array<size_t, RadixBuckets>, NumDigits>;
+
+        RadixSorter(std::span<T> items, std::span<V> values, KeyFunc& key_func)
+            : items_(items)
+            , values_(values)
+            , key_func_(key_func)
+        {
+            assert(!HasValues || values.size() == items.size());
+        }
+
+        void sort()
+        {
+            if (sort_small()) {
+                return;
+            }
+            Histogram hist {};
+            for (const auto& item : items_) {
+                const auto k = key(item);
+                for (size_t d = 0; d < NumDigits; ++d) {
+                    hist[d][digit(k, d)]++;
+                }
+            }
+            const auto skip = skippable_digits(hist);
+            Buffers buffers(items_, values_);
+            for (size_t d = 0; d < NumDigits; ++d) {
+                if (skip[d]) {
+                    continue;
+                }
+                auto offsets = hist[d];
+                exclusive_prefix_sum(offsets);
+                scatter(buffers, d, 0, items_.size(), offsets);
+                buffers.swap();
+            }
+            buffers.finish();
+        }
+
+        void sort_parallel(ThreadPool& pool, size_t grain_size)
+        {
+            assert(grain_size > 0);
+            const auto n = items_.size();
+            const auto num_chunks = (n + grain_size - 1) / grain_size;
+            if (num_chunks < 2 || pool.num_workers() == 0) {
+                sort();
+                return;
+            }
+
+            const auto chunk_range = [&](size_t chunk) {
+                return std::pair(chunk * grain_size, std::min(n, (chunk + 1) * grain_size));
+            };
+
+            // All digit histograms per chunk, only used to find the digits that can be skipped
+            std::vector<Histogram> chunk_hists(num_chunks);
+            pool.run(num_chunks, [&](size_t chunk) {
+                auto& hist = chunk_hists[chunk];
+                hist = {};
+                const auto [begin, end] = chunk_range(chunk);
+                for (auto i = begin; i < end; ++i) {
+                    const auto k = key(items_[i]);
+                    for (size_t d = 0; d < NumDigits; ++d) {
+                        hist[d][digit(k, d)]++;
+                    }
+                }
+            });
+            Histogram total {};
+            for (const auto& hist : chunk_hists) {
+                for (size_t d = 0; d < NumDigits; ++d) {
+                    for (size_t b = 0; b < RadixBuckets; ++b) {
+                        total[d][b] += hist[d][b];
+                    }
+                }
+            }
+
+            const auto skip = skippable_digits(total);
+            Buffers buffers(items_, values_);
+            std::vector<std::array<size_t, RadixBuckets>> offsets(num_chunks);
+            bool first_pass = true;
+            for (size_t d = 0; d < NumDigits; ++d) {
+                if (skip[d]) {
+                    continue;
+                }
+                // The elements move between chunks in every pass, so (except for the first one)
+                // every pass needs new per chunk histograms for its digit.
+                if (first_pass) {
+                    for (size_t c = 0; c < num_chunks; ++c) {
+                        offsets[c] = chunk_hists[c][d];
+                    }
+                } else {
+                    pool.run(num_chunks, [&](size_t chunk) {
+                        auto& counts = offsets[chunk];
+                        counts = {};
+                        const auto [begin, end] = chunk_range(chunk);
+                        for (auto i = begin; i < end; ++i) {
+                            counts[digit(key(buffers.src_items[i]), d)]++;
+                        }
+                    });
+                }
+                first_pass = false;
+
+                // Bucket b of chunk c starts after bucket b of all previous chunks
+                size_t sum = 0;
+                for (size_t b = 0; b < RadixBuckets; ++b) {
+                    for (size_t c = 0; c < num_chunks; ++c) {
+                        const auto count = offsets[c][b];
+                        offsets[c][b] = sum;
+                        sum += count;
+                    }
+                }
+
+                pool.run(num_chunks, [&](size_t chunk) {
+                    const auto [begin, end] = chunk_range(chunk);
+                    scatter(buffers, d, begin, end, offsets[chunk]);
+                });
+                buffers.swap();
+            }
+            buffers.finish();
+        }
+
+    private:
+        // Moves the elements between the items/values and the temporary buffers
+        struct Buffers {
+            std::vector<T> tmp_items;
+            std::vector<V> tmp_values;
+            std::span<T> items, src_items, dst_items;
+            std::span<V> values, src_values, dst_values;
+
+            Buffers(std::span<T> items_in, std::span<V> values_in)
+                : tmp_items(items_in.size())
+                , tmp_values(HasValues ? values_in.size() : 0)
+                , items(items_in)
+                , src_items(items_in)
+                , dst_items(tmp_items)
+                , values(values_in)
+                , src_values(values_in)
+                , dst_values(tmp_values)
+            {
+            }
+
+            void swap()
+            {
+                std::swap(src_items, dst_items);
+                std::swap(src_values, dst_values);
+            }
+
+            // After an odd number of passes the sorted data is in the temporary buffers
+            void finish()
+            {
+                if (src_items.data() != items.data()) {
+                    std::move(src_items.begin(), src_items.end(), items.begin());
+                    if constexpr (HasValues) {
+                        std::move(src_values.begin(), src_values.end(), values.begin());
+                    }
+                }
+            }
+        };
+
+        U key(const T& item) const { return to_radix_key(key_func_(item)); }
+
+        // Digits for which all keys are the same, so their pass wouldn't change anything. This has
+        // to be done before the first scatter, which moves out of items_.
+        std::array<bool, NumDigits> skippable_digits(const Histogram& hist) const
+        {
+            const auto first_key = key(items_[0]);
+            std::array<bool, NumDigits> skip {};
+            for (size_t d = 0; d < NumDigits; ++d) {
+                skip[d] = hist[d][digit(first_key, d)] == items_.size();
+            }
+            return skip;
+        }
+
+        static void exclusive_prefix_sum(std::array<size_t, RadixBuckets>& counts)
+        {
+            size_t sum = 0;
+            for (auto& count : counts) {
+                sum += std::exchange(count, sum);
+            }
+        }
+
+        void scatter(Buffers& buffers, size_t d, size_t begin, size_t end,
+            std::array<size_t, RadixBuckets>& offsets) const
+        {
+            for (auto i = begin; i < end; ++i) {
+                const auto dst = offsets[digit(key(buffers.src_items[i]), d)]++;
+                buffers.dst_items[dst] = std::move(buffers.src_items[i]);
+                if constexpr (HasValues) {
+                    buffers.dst_values[dst] = std::move(buffers.src_values[i]);
+                }
+            }
+        }
+
+        bool sort_small()
+        {
+            // For plain keys stability doesn't matter, because equal elements are identical
+            constexpr bool plain_keys
+                = !HasValues && RadixKey<T> && std::is_same_v<KeyFunc, IdentityKey>;
+            if constexpr (plain_keys) {
+                if (items_.size() <= 256) {
+                    std::sort(items_.begin(), items_.end());
+                    return true;
+                }
+            } else if (items_.size() <= 64) {
+                insertion_sort();
+                return true;
+            }
+            return false;
+        }
+
+        void insertion_sort()
+        {
+            for (size_t i = 1; i < items_.size(); ++i) {
+                const auto k = key(items_[i]);
+                size_t j = i;
+                if (key(items_[j - 1]) <= k) {
+                    continue;
+                }
+                auto item = std::move(items_[i]);
+                V value {};
+                if constexpr (HasValues) {
+                    value = std::move(values_[i]);
+                }
+                while (j > 0 && key(items_[j - 1]) > k) {
+                    items_[j] = std::move(items_[j - 1]);
+                    if constexpr (HasValues) {
+                        values_[j] = std::move(values_[j - 1]);
+                    }
+                    j--;
+                }
+                items_[j] = std::move(item);
+                if constexpr (HasValues) {
+                    values_[j] = std::move(value);
+                }
+            }
+        }
+
+        std::span<T> items_;
+        std::span<V> values_;
+        KeyFunc& key_func_;
+    };
+
+    template <typename T, typename V, typename KeyFunc>
+    void radix_sort(std::span<T> items, std::span<V> values, KeyFunc key_func, ThreadPool* pool,
+        size_t grain_size)
+    {
+        RadixSorter<T, V, KeyFunc> sorter(items, values, key_func);
+        if (pool) {
+            sorter.sort_parallel(*pool, grain_size);
+        } else {
+            sorter.sort();
+        }
+    }
+}
+
+template <std::ranges::contiguous_range Keys>
+    requires detail::RadixKey<std::ranges::range_value_t<Keys>>
+void radix_sort(Keys&& keys)
+{
+    detail::radix_sort(std::span(keys), std::span<detail::NoPayload>(), detail::IdentityKey(),
+        nullptr, 0);
+}
+
+// Sorts keys and applies the same permutation to values
+template <std::ranges::contiguous_range Keys, std::ranges::contiguous_range Values>
+    requires detail::RadixKey<std::ranges::range_value_t<Keys>>
+void radix_sort(Keys&& keys, Values&& values)
+{
+    detail::radix_sort(std::span(keys), std::span(values), detail::IdentityKey(), nullptr, 0);
+}
+
+// key_func(const Item&) has to return an integer
+template <std::ranges::contiguous_range Items, typename KeyFunc>
+void radix_sort_by(Items&& items, KeyFunc key_func)
+{
+    detail::radix_sort(std::span(items), std::span<detail::NoPayload>(), key_func, nullptr, 0);
+}
+
+namespace parallel {
+    // Every chunk of grain_size elements is counted and scattered by a single thread
+    constexpr size_t DefaultRadixSortGrainSize = 1 << 16;
+
+    template <std::ranges::contiguous_range Keys>
+        requires pasta::detail::RadixKey<std::ranges::range_value_t<Keys>>
+    void radix_sort(Keys&& keys, ThreadPool& pool = getThreadPool(),
+        size_t grain_size = DefaultRadixSortGrainSize)
+    {
+        pasta::detail::radix_sort(std::span(keys), std::span<pasta::detail::NoPayload>(),
+            pasta::detail::IdentityKey(), &pool, grain_size);
+    }
+
+    template <std::ranges::contiguous_range Keys, std::ranges::contiguous_range Values>
+        requires pasta::detail::RadixKey<std::ranges::range_value_t<Keys>>
+    void radix_sort(Keys&& keys, Values&& values, ThreadPool& pool = getThreadPool(),
+        size_t grain_size = DefaultRadixSortGrainSize)
+    {
+        pasta::detail::radix_sort(std::span(keys), std::span(values),
+            pasta::detail::IdentityKey(), &pool, grain_size);
+    }
+
+    template <std::ranges::contiguous_range Items, typename KeyFunc>
+    void radix_sort_by(Items&& items, KeyFunc key_func, ThreadPool& pool = getThreadPool(),
+        size_t grain_size = DefaultRadixSortGrainSize)
+    {
+        pasta::detail::radix_sort(std::span(items), std::span<pasta::detail::NoPayload>(),
+            key_func, &pool, grain_size);
+    }
+}
+
+}
@@ -6,7 +6,15 @@
 
 namespace pasta {
 
-std::default_random_engine& getRng();
+// Set CPPASTA_RNG_ENGINE (the CMake cache variable, so it's the same everywhere) to use a different
+// engine for all the functions in here, e.g. std::mt19937. benchmarks/random.cpp can check it.
+#ifdef CPPASTA_RNG_ENGINE
+using RngEngine = CPPASTA_RNG_ENGINE;
+#else
+using RngEngine = std::default_random_engine;
+#endif
+
+RngEngine& getRng();
 
 template <typename IntType>
 std::enable_if_t<std::is_integral_v<IntType>, IntType> random(IntType min, IntType max)
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <vector>
+
+/* RoaringBitmap
+
+A compressed set of 32-bit integers (usually key.idx() of a SlotMap or DenseSlotMap), after
+"Better bitmap performance with Roaring bitmaps" (Chambi, Lemire et al.).
+
+The 32-bit space is split into chunks of 2^16 values by the upper 16 bits. Every non-empty chunk
+has a container for the lower 16 bits, which is one of:
+- Array: a sorted array of up to 4096 values (2 bytes per value)
+- Bitmap: 2^16 bits (8 KiB), used as soon as there are more than 4096 values
+- Run: sorted (start, length - 1) pairs, for long contiguous ranges
+So a sparse set costs about 2 bytes per element and a dense one about 1 bit per element.
+
+Set operations work container by container. Bitmap/bitmap operations are plain word loops (SSE2
+if available) and array/array intersections use galloping if one array is much smaller than the
+other. Run containers are only created by add_range and run_optimize. Modifying them (add/remove)
+or combining them with other containers converts them to an array or bitmap first, so call
+run_optimize again after modifications if memory matters.
+
+serialize/deserialize use a simple little-endian format of their own, which is not compatible
+with the portable format of the reference implementation.
+*/
+
+namespace pasta {
+
+namespace detail {
+    struct RoaringContainer {
+        enum class Type : uint8_t { Array = 0, Bitmap = 1, Run = 2 };
+
+        static constexpr uint32_t MaxArraySize = 4096;
+        static constexpr uint32_t BitmapWords = 65536 / 64;
+
+        Type type = Type::Array;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> values; // Array: sorted values, Run: (start, length - 1) pairs
+        std::vector<uint64_t> words; // Bitmap
+    };
+
+    template <typename Func>
+    void for_each_in_container(const RoaringContainer& c, uint16_t key, Func& func)
+    {
+        using Type = RoaringContainer::Type;
+        const auto high = static_cast<uint32_t>(key) << 16;
+        switch (c.type) {
+        case Type::Array:
+            for (const auto v : c.values) {
+                func(high | v);
+            }
+            break;
+        case Type::Bitmap:
+            for (uint32_t w = 0; w < c.words.size(); ++w) {
+                auto word = c.words[w];
+                while (word) {
+                    func(high | (w * 64 + static_cast<uint32_t>(std::countr_zero(word))));
+                    word &= word - 1;
+                }
+            }
+            break;
+        case Type::Run:
+            for (size_t r = 0; r < c.values.size(); r += 2) {
+                const uint32_t start = c.values[r];
+                const uint32_t last = start + c.values[r + 1];
+                for (uint32_t v = start; v <= last; ++v) {
+                    func(high | v);
+                }
+            }
+            break;
+        }
+    }
+}
+
+class RoaringBitmap {
+public:
+    RoaringBitmap() = default;
+    RoaringBitmap(std::initializer_list<uint32_t> values);
+
+    // Returns true if the value was not in the set yet
+    bool add(uint32_t value);
+    // Much faster if values is sorted
+    void add_many(std::span<const uint32_t> values);
+    // Adds [begin, end)
+    void add_range(uint64_t begin, uint64_t end);
+    // Returns true if the value was in the set
+    bool remove(uint32_t value);
+    bool contains(uint32_t value) const;
+
+    uint64_t size() const;
+    bool empty() const { return keys_.empty(); }
+    void clear();
+
+    std::optional<uint32_t> min() const;
+    std::optional<uint32_t> max() const;
+
+    RoaringBitmap& operator|=(const RoaringBitmap& other);
+    RoaringBitmap& operator&=(const RoaringBitmap& other);
+    RoaringBitmap& operator-=(const RoaringBitmap& other);
+
+    // Does not materialize the intersection
+    bool intersects(const RoaringBitmap& other) const;
+    uint64_t intersection_size(const RoaringBitmap& other) const;
+
+    bool operator==(const RoaringBitmap& other) const;
+
+    // Converts containers to run containers where that is smaller and back where it is not.
+    // Returns true if any container is a run container afterwards.
+    bool run_optimize();
+
+    // Approximate heap memory used by the containers
+    size_t memory_usage() const;
+
+    // Calls func(uint32_t) for every value in ascending order
+    template <typename Func>
+    void for_each(Func&& func) const
+    {
+        for (size_t c = 0; c < keys_.size(); ++c) {
+            detail::for_each_in_container(containers_[c], keys_[c], func);
+        }
+    }
+
+    std::vector<uint32_t> to_vector() const;
+
+    std::vector<uint8_t> serialize() const;
+    // Returns std::nullopt if the data is truncated or invalid
+    static std::optional<RoaringBitmap> deserialize(std::span<const uint8_t> data);
+
+private:
+    using Container = detail::RoaringContainer;
+
+    // Returns the index of the container for key or containers_.size() if there is none
+    size_t find_container(uint16_t key) const;
+    Container& get_or_insert_container(uint16_t key);
+    void erase_container(size_t index);
+
+    std::vector<uint16_t> keys_; // sorted, upper 16 bits
+    std::vector<Container> containers_;
+};
+
+inline RoaringBitmap operator|(RoaringBitmap a, const RoaringBitmap& b)
+{
+    a |= b;
+    return a;
+}
+
+inline RoaringBitmap operator&(RoaringBitmap a, const RoaringBitmap& b)
+{
+    a &= b;
+    return a;
+}
+
+inline RoaringBitmap operator-(RoaringBitmap a, const RoaringBitmap& b)
+{
+    a -= b;
+    return a;
+}
+
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 
+#include "dynamic_bitset.hpp"
+
 namespace pasta {
 
 template <typename T>
@@ -11,6 +14,7 @@ concept Skipfield = requires(T sf) {
     { sf.set_not_skipped(std::declval<size_t>()) } -> std::same_as<void>;
     { sf.get_num_skipped(std::declval<size_t>()) } -> std::unsigned_integral;
     { sf.resize(std::declval<size_t>(), std::declval<bool>()) } -> std::same_as<void>;
+    { sf.set_all_skipped() } -> std::same_as<void>;
 };
 
 /* IntSkipfield
@@ -81,7 +85,7 @@ class IntSkipfield {
 public:
     IntSkipfield(size_t size, bool init_skipped) : num_skipped_(size, 0)
     {
-        if (init_skipped) {
+        if (init_skipped && size > 0) {
             set_range_skipped(0, size);
         }
     }
@@ -165,6 +169,13 @@ public:
         }
     }
 
+    void set_all_skipped()
+    {
+        if (num_skipped_.size() > 0) {
+            set_range_skipped(0, num_skipped_.size());
+        }
+    }
+
     size_t get_num_skipped(size_t idx) const
     {
         assert(idx < num_skipped_.size());
@@ -211,6 +222,8 @@ public:
         skipped_[idx] = 0;
     }
 
+    void set_all_skipped() { std::fill(skipped_.begin(), skipped_.end(), 1); }
+
     size_t get_num_skipped(size_t idx) const
     {
         assert(idx < skipped_.size());
@@ -227,12 +240,52 @@ private:
     Storage<uint8_t> skipped_; // vector<bool> is evil
 };
 
+// Like BoolSkipfield, but with a bit per element. Finding the end of a skipped block scans 64
+// elements at a time, so this is much faster for long skipped blocks as well.
+class BitSkipfield {
+public:
+    BitSkipfield(size_t size, bool init_skipped) : skipped_(size, init_skipped) { }
+
+    void resize(size_t size, bool init_skipped)
+    {
+        assert(size > skipped_.size());
+        skipped_.resize(size, init_skipped);
+    }
+
+    void set_skipped(size_t idx)
+    {
+        assert(!skipped_.test(idx));
+        skipped_.set(idx);
+    }
+
+    void set_not_skipped(size_t idx)
+    {
+        assert(skipped_.test(idx));
+        skipped_.reset(idx);
+    }
+
+    void set_all_skipped() { skipped_.set(); }
+
+    size_t get_num_skipped(size_t idx) const
+    {
+        assert(idx < skipped_.size());
+        const auto next = skipped_.find_next_unset(idx);
+        return (next == DynamicBitset::npos ? skipped_.size() : next) - idx;
+    }
+
+    size_t size() const { return skipped_.size(); }
+
+private:
+    DynamicBitset skipped_;
+};
+
 struct NullSkipfield {
-    NullSkipfield(size_t, bool) { }
-    void resize(size_t, bool) { }
-    void set_skipped(size_t) { }
-    void set_not_skipped(size_t) { }
-    size_t get_num_skipped(size_t) const { return 0; }
+    constexpr NullSkipfield(size_t, bool) { }
+    constexpr void resize(size_t, bool) { }
+    constexpr void set_skipped(size_t) { }
+    constexpr void set_not_skipped(size_t) { }
+    constexpr void set_all_skipped() { }
+    constexpr size_t get_num_skipped(size_t) const { return 0; }
 };
 
 }
\ No newline at end of file
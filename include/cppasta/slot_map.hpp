@@ -1,6 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
 
 #include "generational_index.hpp"
 #include "skipfield.hpp"
@@ -70,6 +76,60 @@ SparseVector and a list of current generations, but then I can store the next ge
 
 namespace pasta {
 
+/* CachedHandle
+
+A key together with the pointer to the element and to the generation of its slot, so
+dereferencing it is a single load and compare instead of a full lookup (for PagedSlotMapStorage
+that includes finding the page). Get one from SlotMap::cache. This only works for storages that
+keep both elements and generations at stable addresses (PagedSlotMapStorage) and the handle must
+not outlive the map.
+*/
+template <typename T, GenerationalIndex KeyType = CompositeId<T>,
+    typename Generation = typename KeyType::GenerationType>
+class CachedHandle {
+public:
+    using Key = KeyType;
+
+    // Invalid
+    constexpr CachedHandle() = default;
+
+    constexpr CachedHandle(Key key, T* element, const Generation* generation)
+        : key_(key)
+        , element_(element)
+        , generation_(generation)
+    {
+    }
+
+    constexpr Key key() const { return key_; }
+
+    // Returns nullptr if the element has been removed from the map
+    constexpr T* get() const { return *generation_ == key_.gen() ? element_ : nullptr; }
+
+    constexpr bool valid() const { return get() != nullptr; }
+
+    constexpr explicit operator bool() const { return valid(); }
+
+    constexpr T& operator*() const
+    {
+        assert(valid());
+        return *element_;
+    }
+
+    constexpr T* operator->() const
+    {
+        assert(valid());
+        return element_;
+    }
+
+private:
+    // The default handle has a key with generation 0, so it "matches" this, but element_ is null
+    static constexpr Generation null_generation = 0;
+
+    Key key_ = Key();
+    T* element_ = nullptr;
+    const Generation* generation_ = &null_generation;
+};
+
 // I realize all these template arguments are horrifying. I would probably never have it like this
 // in a game, but since this is library code, I want it to be as customizable as possible, which it
 // now is.
@@ -82,99 +142,125 @@ public:
     using Value = T;
 
     // The default arguments disallow growing
-    SlotMap(size_t capacity, size_t growth_constant = 0, float growth_factor = 1.0f)
+    constexpr SlotMap(size_t capacity, size_t growth_constant = 0, float growth_factor = 1.0f)
         : storage_(capacity)
-        , skipfield_(capacity, true)
+        , skipfield_(0, true)
         , growth_constant_(growth_constant)
         , growth_factor_(growth_factor)
     {
-        // Initialize free list
-        for (size_t i = 0; i < storage_.size(); ++i) {
-            storage_.store_free_list(i, i + 1);
-        }
     }
 
-    ~SlotMap() { clear(); }
+    constexpr ~SlotMap() { clear(); }
 
-    void resize(size_t size)
-    {
-        const auto old_size = storage_.size();
-        storage_.resize(size);
-        skipfield_.resize(size, true);
-        for (size_t i = old_size; i < size - 1; ++i) {
-            storage_.store_free_list(i, i + 1);
-        }
-        storage_.store_free_list(size - 1, free_list_head_);
-        free_list_head_ = old_size;
-    }
+    // The storage might not resize to exactly the requested size (e.g. PagedSlotMapStorage)
+    constexpr void resize(size_t size) { storage_.resize(size); }
 
-    Key insert(T&& value)
+    // Constructs the element directly in its slot (with `T(args...)`, like emplace_back)
+    template <typename... Args>
+    constexpr Key emplace(Args&&... args)
     {
-        auto idx = free_list_head_;
-        if (free_list_head_ >= storage_.size()) {
-            // Space exhausted
-            const auto new_size
-                = static_cast<size_t>(storage_.size() * growth_factor_) + growth_constant_;
-            assert(new_size > storage_.size() && "SlotMap full");
-            resize(new_size);
-        } else {
-            assert(storage_.gen(free_list_head_) == 0);
-            free_list_head_ = storage_.free_list(free_list_head_);
+        if (free_list_head_ == FreeListEnd && high_water_mark_ == storage_.size()) {
+            if constexpr (std::is_move_constructible_v<T>) {
+                // args might refer to an element of this map (e.g. `emplace(*get(key))`), which
+                // growing would move, so we construct the new element before.
+                T value(std::forward<Args>(args)...);
+                grow();
+                return emplace_at(next_free(), std::move(value));
+            } else {
+                // Storages that can grow with non-movable T (e.g. PagedSlotMapStorage) don't move
+                // the existing elements.
+                grow();
+            }
         }
-        const auto key = Key(static_cast<Key::IndexType>(idx), generation_);
-        generation_ = key.next_generation().gen();
-        storage_.store_element(key.idx(), std::move(value));
-        skipfield_.set_not_skipped(key.idx());
-        storage_.gen(key.idx()) = key.gen();
-        size_++;
-        return key;
+        return emplace_at(next_free(), std::forward<Args>(args)...);
     }
 
-    Key insert(const T& value) { return insert(T { value }); }
+    constexpr Key insert(T&& value) { return emplace(std::move(value)); }
 
-    bool remove(Key key)
+    constexpr Key insert(const T& value) { return emplace(value); }
+
+    constexpr bool remove(Key key)
     {
-        const auto idx = key.idx();
-        assert(idx < storage_.size());
-        if (!key.valid() || key.gen() != storage_.gen(idx)) {
+        if (!contains(key)) {
             return false;
         }
+        const auto idx = key.idx();
         storage_.destroy_element(idx, free_list_head_);
         free_list_head_ = idx;
-        storage_.gen(idx) = 0;
+        storage_.set_gen(idx, 0);
         skipfield_.set_skipped(idx);
         size_--;
         return true;
     }
 
-    bool contains(const Key& key) const
+    constexpr bool contains(const Key& key) const
     {
         assert(key.idx() < storage_.size());
-        return key.valid() && storage_.gen(key.idx()) == key.gen();
+        return key.valid() && key.idx() < high_water_mark_ && storage_.gen(key.idx()) == key.gen();
     }
 
-    T* find(Key key) { return contains(key) ? get(key) : nullptr; }
+    constexpr T* find(Key key) { return contains(key) ? get(key) : nullptr; }
 
-    const T* find(Key key) const { return contains(key) ? get(key) : nullptr; }
+    constexpr const T* find(Key key) const { return contains(key) ? get(key) : nullptr; }
 
-    T* get(Key key)
+    constexpr T* get(Key key)
     {
         assert(contains(key));
         return storage_.data(key.idx());
     }
 
-    const T* get(Key key) const
+    constexpr const T* get(Key key) const
     {
         assert(contains(key));
         return storage_.data(key.idx());
     }
 
+    // Returns an invalid handle if key is not contained
+    auto cache(Key key)
+        requires requires(const Storage<T, Key>& storage) { storage.gen_address(size_t(0)); }
+    {
+        using Generation = std::remove_cvref_t<decltype(*storage_.gen_address(0))>;
+        using Handle = CachedHandle<T, Key, Generation>;
+        if (!contains(key)) {
+            return Handle();
+        }
+        return Handle(key, storage_.data(key.idx()), storage_.gen_address(key.idx()));
+    }
+
+    // Resolves many keys at once: out[i] = find(keys[i]). The generations are prefetched a few keys
+    // ahead, so the cache misses of random keys overlap instead of being paid one after another.
+    void find_many(std::span<const Key> keys, std::span<T*> out)
+    {
+        lookup_many<false>(*this, keys, out);
+    }
+
+    void find_many(std::span<const Key> keys, std::span<const T*> out) const
+    {
+        lookup_many<false>(*this, keys, out);
+    }
+
+    // Like find_many, but all keys must be contained (the generations are only checked in an
+    // assert). Resolving a key is only address arithmetic then and doesn't load anything, so
+    // nothing is prefetched. Prefetching the elements made this several times slower in
+    // bench_slot_map.
+    void get_many(std::span<const Key> keys, std::span<T*> out)
+    {
+        lookup_many<true>(*this, keys, out);
+    }
+
+    void get_many(std::span<const Key> keys, std::span<const T*> out) const
+    {
+        lookup_many<true>(*this, keys, out);
+    }
+
     // Because you delete by key, next returns Key (also no const-overloading)
-    Key next(Key key) const
+    constexpr Key next(Key key) const
     {
         auto i = key.valid() ? key.idx() + 1 : 0;
-        i += static_cast<decltype(i)>(skipfield_.get_num_skipped(i));
-        for (; static_cast<size_t>(i) < storage_.size(); ++i) {
+        if (static_cast<size_t>(i) < high_water_mark_) {
+            i += static_cast<decltype(i)>(skipfield_.get_num_skipped(i));
+        }
+        for (; static_cast<size_t>(i) < high_water_mark_; ++i) {
             // If an actual skip field is used, the first iteration of this loop should return
             if (storage_.gen(i) > 0) {
                 return Key(i, storage_.gen(i));
@@ -186,24 +272,115 @@ public:
     // Maybe this function would make sense (probably), I am not sure yet.
     // Id get_id(const T* elem) const;
 
-    size_t size() const { return size_; }
+    constexpr size_t size() const { return size_; }
 
-    size_t capacity() const { return storage_.size(); }
+    constexpr size_t capacity() const { return storage_.size(); }
 
-    void clear()
+    // Instead of removing the elements one by one, this destroys them in one pass (which is skipped
+    // completely for trivially destructible T), resets the generations and the skipfield in bulk
+    // and simply forgets the free list, because all slots are below the high water mark again.
+    constexpr void clear()
     {
-        for (size_t i = 0; i < storage_.size(); ++i) {
-            if (storage_.gen(i) > 0) {
-                remove(Key(i, storage_.gen(i)));
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < high_water_mark_; ++i) {
+                if (storage_.gen(i) > 0) {
+                    std::destroy_at(storage_.data(i));
+                }
             }
         }
+        storage_.clear_generations(high_water_mark_);
+        if (size_ > 0) {
+            skipfield_.set_all_skipped();
+        }
+        size_ = 0;
+        free_list_head_ = FreeListEnd;
+        high_water_mark_ = 0;
     }
 
 private:
+    constexpr void grow()
+    {
+        const auto new_size
+            = static_cast<size_t>(storage_.size() * growth_factor_) + growth_constant_;
+        assert(new_size > storage_.size() && "SlotMap full");
+        resize(new_size);
+    }
+
+    // Pops the free list or, if it's empty, takes the first slot that was never used.
+    // The map must not be full.
+    constexpr size_t next_free()
+    {
+        if (free_list_head_ != FreeListEnd) {
+            const auto idx = free_list_head_;
+            free_list_head_ = storage_.free_list(idx);
+            return idx;
+        }
+        assert(high_water_mark_ < storage_.size());
+        if (high_water_mark_ == num_initialized_) {
+            // Grow geometrically, so IntSkipfield doesn't rewrite the skipped block at the end on
+            // every insert
+            num_initialized_
+                = std::min(storage_.size(), std::max(2 * num_initialized_, size_t(64)));
+            storage_.init_generations(num_initialized_);
+            skipfield_.resize(num_initialized_, true);
+        }
+        return high_water_mark_++;
+    }
+
+    template <typename... Args>
+    constexpr Key emplace_at(size_t idx, Args&&... args)
+    {
+        assert(idx < high_water_mark_);
+        assert(storage_.gen(idx) == 0);
+        const auto key = Key(static_cast<Key::IndexType>(idx), generation_);
+        // The storage might store fewer bits than Key has
+        generation_ = generation_ < storage_.max_generation() ? generation_ + 1 : 1;
+        storage_.emplace_element(key.idx(), std::forward<Args>(args)...);
+        skipfield_.set_not_skipped(key.idx());
+        storage_.set_gen(key.idx(), key.gen());
+        size_++;
+        return key;
+    }
+
+    template <bool AllContained, typename Self, typename Ptr>
+    static void lookup_many(Self& self, std::span<const Key> keys, std::span<Ptr> out)
+    {
+        assert(out.size() >= keys.size());
+        if constexpr (AllContained) {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                out[i] = self.get(keys[i]);
+            }
+        } else {
+            const auto prefetch_gen = [&self](Key key) {
+                if (key.idx() < self.high_water_mark_) {
+                    self.storage_.prefetch_gen(key.idx());
+                }
+            };
+            for (size_t i = 0; i < std::min(keys.size(), PrefetchDistance); ++i) {
+                prefetch_gen(keys[i]);
+            }
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (i + PrefetchDistance < keys.size()) {
+                    prefetch_gen(keys[i + PrefetchDistance]);
+                }
+                out[i] = self.find(keys[i]);
+            }
+        }
+    }
+
+    static constexpr uint32_t FreeListEnd = std::numeric_limits<uint32_t>::max();
+
     Storage<T, Key> storage_;
     Skipfield skipfield_;
     size_t size_ = 0;
-    size_t free_list_head_ = 0;
+    // Only slots that were removed are on the free list. Slots at and above the high water mark
+    // were never used (since construction or the last clear) and are handed out in order, so the
+    // free list never has to be initialized.
+    size_t free_list_head_ = FreeListEnd;
+    size_t high_water_mark_ = 0;
+    // The generations and the skipfield are only initialized up to here (>= high_water_mark_), so
+    // constructing and growing the map doesn't touch (and page in) the memory of unused slots.
+    size_t num_initialized_ = 0;
     size_t growth_constant_ = 0;
     float growth_factor_ = 1.0f;
     Key::GenerationType generation_ = 1;
@@ -1,27 +1,184 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include "generational_index.hpp"
+#include "prefetch.hpp"
 
 namespace pasta {
 
 template <typename S>
 concept SlotMapStorage = requires(S s) {
-    { s.store_free_list(std::declval<size_t>(), std::declval<uint32_t>()) } -> std::same_as<void>;
+    // Has to construct the element in place from any arguments (forwarded from SlotMap::emplace),
+    // not only from an Element, with parentheses (`T(args...)`) like all other emplace functions.
     {
-        s.store_element(std::declval<size_t>(), std::declval<typename S::Element>())
+        s.emplace_element(std::declval<size_t>(), std::declval<typename S::Element>())
     } -> std::same_as<void>;
     { s.destroy_element(std::declval<size_t>(), std::declval<uint32_t>()) } -> std::same_as<void>;
     { s.resize(std::declval<size_t>()) } -> std::same_as<void>;
+    // gen(idx) may only be called for idx < count after init_generations(count), which sets the
+    // newly initialized generations to 0. count never decreases and is at most size().
+    { s.init_generations(std::declval<size_t>()) } -> std::same_as<void>;
+    // Sets the generations of [0, count) to 0 in bulk (SlotMap::clear). The elements in these
+    // slots have been destroyed already.
+    { s.clear_generations(std::declval<size_t>()) } -> std::same_as<void>;
     { std::as_const(s).size() } -> std::convertible_to<size_t>;
     { s.data(std::declval<size_t>()) } -> std::same_as<typename S::Element*>;
     { std::as_const(s).data(std::declval<size_t>()) } -> std::same_as<const typename S::Element*>;
     { std::as_const(s).free_list(std::declval<size_t>()) } -> std::same_as<uint32_t>;
-    { s.gen(std::declval<size_t>()) } -> std::same_as<typename S::GenerationType&>;
+    // Generations are get and set by value, so they can be stored narrower than GenerationType
+    // (e.g. bit-packed). SlotMap only hands out generations in [1, max_generation()].
+    { std::as_const(s).gen(std::declval<size_t>()) } -> std::same_as<typename S::GenerationType>;
+    {
+        s.set_gen(std::declval<size_t>(), std::declval<typename S::GenerationType>())
+    } -> std::same_as<void>;
+    { std::as_const(s).max_generation() } -> std::same_as<typename S::GenerationType>;
+    { std::as_const(s).prefetch_gen(std::declval<size_t>()) } -> std::same_as<void>;
+};
+
+/* PackedGenerations
+
+A GenerationStorage that packs generations with Bits bits each, e.g. PackedGenerations<6> uses
+6 bits per slot instead of the 32 bits of std::vector<uint32_t>. Instead of a narrow generation
+storage you could also simply use a narrow vector (e.g. std::vector<uint8_t>).
+
+Keep in mind that the fewer bits you use, the more likely it is that a stale key is considered
+valid again after its slot has been reused. With N bits a stale key has a chance of about
+1/(2^N - 1) to match whenever its slot is reused.
+*/
+template <size_t Bits, template <typename> typename Storage = std::vector>
+class PackedGenerations {
+public:
+    static_assert(Bits >= 2 && Bits <= 32);
+    using value_type = uint32_t;
+    static constexpr value_type max_value = static_cast<value_type>((uint64_t(1) << Bits) - 1);
+
+    PackedGenerations() = default;
+    PackedGenerations(size_t size, value_type value) { resize(size, value); }
+
+    size_t size() const { return size_; }
+
+    void resize(size_t size, value_type value)
+    {
+        // One word more than necessary, so reading the word after the last one is always valid
+        words_.resize((size * Bits + 63) / 64 + 1, 0);
+        for (size_t i = size_; i < size; ++i) {
+            set(i, value);
+        }
+        size_ = size;
+    }
+
+    value_type operator[](size_t idx) const
+    {
+        const auto bit = idx * Bits;
+        const auto word = bit / 64;
+        const auto shift = bit % 64;
+        auto v = words_[word] >> shift;
+        if (shift + Bits > 64) {
+            v |= words_[word + 1] << (64 - shift);
+        }
+        return static_cast<value_type>(v & max_value);
+    }
+
+    void set(size_t idx, value_type value)
+    {
+        assert(value <= max_value);
+        const auto bit = idx * Bits;
+        const auto word = bit / 64;
+        const auto shift = bit % 64;
+        words_[word]
+            = (words_[word] & ~(uint64_t(max_value) << shift)) | (uint64_t(value) << shift);
+        if (shift + Bits > 64) {
+            const auto hi_shift = 64 - shift;
+            words_[word + 1] = (words_[word + 1] & ~(uint64_t(max_value) >> hi_shift))
+                | (uint64_t(value) >> hi_shift);
+        }
+    }
+
+    // Sets the first count values to 0
+    void reset(size_t count)
     {
-        std::as_const(s).gen(std::declval<size_t>())
-    } -> std::same_as<const typename S::GenerationType&>;
+        assert(count <= size_);
+        const auto full_words = count * Bits / 64;
+        std::fill_n(words_.begin(), full_words, 0);
+        for (size_t i = full_words * 64 / Bits; i < count; ++i) {
+            set(i, 0);
+        }
+    }
+
+    const void* address(size_t idx) const { return &words_[idx * Bits / 64]; }
+
+private:
+    Storage<uint64_t> words_;
+    size_t size_ = 0;
 };
 
+namespace detail {
+    // These make std containers of unsigned integers and PackedGenerations usable the same way
+
+    template <typename GenerationStorage>
+    constexpr uint64_t max_generation()
+    {
+        if constexpr (requires { GenerationStorage::max_value; }) {
+            return GenerationStorage::max_value;
+        } else {
+            return std::numeric_limits<typename GenerationStorage::value_type>::max();
+        }
+    }
+
+    template <typename GenerationStorage, typename Value>
+    void set_generation(GenerationStorage& gens, size_t idx, Value value)
+    {
+        if constexpr (requires { gens.set(idx, value); }) {
+            gens.set(idx, static_cast<typename GenerationStorage::value_type>(value));
+        } else {
+            gens[idx] = static_cast<typename GenerationStorage::value_type>(value);
+        }
+    }
+
+    template <typename GenerationStorage>
+    void reset_generations(GenerationStorage& gens, size_t count)
+    {
+        if constexpr (requires { gens.reset(count); }) {
+            gens.reset(count);
+        } else {
+            std::fill_n(gens.begin(), count, typename GenerationStorage::value_type(0));
+        }
+    }
+
+    template <typename GenerationStorage>
+    const void* generation_address(const GenerationStorage& gens, size_t idx)
+    {
+        if constexpr (requires { gens.address(idx); }) {
+            return gens.address(idx);
+        } else {
+            return &gens[idx];
+        }
+    }
+
+    // The smaller of what the Key and what the GenerationStorage can represent
+    template <GenerationalIndex KeyType, typename GenerationStorage>
+    constexpr typename KeyType::GenerationType max_generation()
+    {
+        uint64_t key_max = std::numeric_limits<typename KeyType::GenerationType>::max();
+        if constexpr (requires { KeyType::max(); }) {
+            // Keys might have fewer bits than GenerationType (e.g. BitFieldId)
+            key_max = KeyType::max().gen();
+        }
+        return static_cast<KeyType::GenerationType>(
+            std::min(key_max, max_generation<GenerationStorage>()));
+    }
+}
+
 template <typename T>
 struct AlignedStorage {
     alignas(T) uint8_t data[sizeof(T)];
@@ -47,41 +204,51 @@ public:
 
     GrowableSlotMapStorage(size_t capacity, const Allocator<ElementStorage<T>>& alloc = {})
         : data_(alloc_.allocate(capacity))
-        , generations_(capacity, 0)
         , alloc_(alloc)
+        , capacity_(capacity)
     {
     }
 
     // Every element HAS TO BE DESTROYED before the destructor is called, or we will get undefined
     // behavior.
-    ~GrowableSlotMapStorage() { alloc_.deallocate(data_, generations_.size()); }
+    ~GrowableSlotMapStorage() { alloc_.deallocate(data_, capacity_); }
 
+    // Only moves the elements and free list links of slots that were ever used. The others never
+    // had a link written to them.
     void resize(size_t size)
     {
+        assert(size >= generations_.size());
         const auto new_data = alloc_.allocate(size);
-        for (size_t i = 0; i < generations_.size(); ++i) {
+        for (size_t i = 0; i < used_; ++i) {
             if (generations_[i] > 0) {
-                new (new_data + i) T { std::move(*data(i)) };
+                new (new_data + i) T(std::move(*data(i)));
                 reinterpret_cast<T*>(data_ + i)->~T();
             } else {
+                // Might be a stale link (after SlotMap::clear), which is never read
+                new (new_data + i) uint32_t { free_list(i) };
                 reinterpret_cast<uint32_t*>(data_ + i)->~uint32_t();
             }
         }
-        alloc_.deallocate(data_, generations_.size());
+        alloc_.deallocate(data_, capacity_);
         data_ = new_data;
-        generations_.resize(size, 0);
+        capacity_ = size;
     }
 
-    void store_free_list(size_t idx, uint32_t free_list)
+    void init_generations(size_t count)
     {
-        new (data_ + idx) uint32_t { free_list };
+        assert(count >= generations_.size() && count <= capacity_);
+        generations_.resize(count, 0);
     }
 
-    void store_element(size_t idx, T&& t)
+    void clear_generations(size_t count) { detail::reset_generations(generations_, count); }
+
+    template <typename... Args>
+    void emplace_element(size_t idx, Args&&... args)
     {
         assert(generations_[idx] == 0);
         reinterpret_cast<uint32_t*>(data_ + idx)->~uint32_t();
-        new (data_ + idx) T { std::move(t) };
+        new (data_ + idx) T(std::forward<Args>(args)...);
+        used_ = std::max(used_, idx + 1);
     }
 
     void destroy_element(size_t idx, uint32_t free_list)
@@ -91,7 +258,7 @@ public:
         new (data_ + idx) uint32_t { free_list };
     }
 
-    auto size() const { return generations_.size(); }
+    auto size() const { return capacity_; }
 
     T* data(size_t idx) { return reinterpret_cast<T*>(data_ + idx); }
     const T* data(size_t idx) const { return reinterpret_cast<const T*>(data_ + idx); }
@@ -101,16 +268,32 @@ public:
         return *reinterpret_cast<const uint32_t*>(data_ + idx);
     };
 
-    GenerationType& gen(size_t idx) { return generations_[idx]; }
-    const GenerationType& gen(size_t idx) const { return generations_[idx]; }
+    GenerationType gen(size_t idx) const { return static_cast<GenerationType>(generations_[idx]); }
+
+    void set_gen(size_t idx, GenerationType gen)
+    {
+        detail::set_generation(generations_, idx, gen);
+    }
+
+    GenerationType max_generation() const
+    {
+        return detail::max_generation<KeyType, GenerationStorage>();
+    }
+
+    void prefetch_gen(size_t idx) const { prefetch(detail::generation_address(generations_, idx)); }
 
 private:
     ElementStorage<T>* data_;
     GenerationStorage generations_;
     Allocator<ElementStorage<T>> alloc_;
+    size_t capacity_;
+    // Slots at and above this were never used, so they hold neither an element nor a link
+    size_t used_ = 0;
 };
 
-// This keeps element pointers stable and allocates in pages
+// This keeps element pointers stable and allocates in pages. The generations are stored in blocks
+// that never move either, so pointers to them are stable as well (see CachedHandle). The blocks
+// are much smaller than a page, so generations are still initialized only as they are needed.
 template <typename T, GenerationalIndex KeyType, typename GenerationStorage,
     template <typename> typename Allocator>
 struct PagedSlotMapStorage {
@@ -121,7 +304,6 @@ public:
     PagedSlotMapStorage(size_t capacity, const Allocator<ElementStorage<T>>& allocT = {},
         const Allocator<ElementStorage<T>*> allocP = {})
         : pages_(allocP_.allocate(1))
-        , generations_(capacity, 0)
         , allocT_(allocT)
         , allocP_(allocP)
         , page_size_(capacity)
@@ -144,7 +326,7 @@ public:
     void resize(size_t)
     {
         const auto new_page = allocT_.allocate(page_size_);
-        const auto new_pages = allocP_.allocate(num_pages_);
+        const auto new_pages = allocP_.allocate(num_pages_ + 1);
         for (size_t i = 0; i < num_pages_; ++i) {
             new_pages[i] = pages_[i];
         }
@@ -152,28 +334,43 @@ public:
         allocP_.deallocate(pages_, num_pages_);
         pages_ = new_pages;
         num_pages_++;
-        generations_.resize(generations_.size() + page_size_, 0);
     }
 
-    void store_free_list(size_t idx, uint32_t free_list) { new (data(idx)) uint32_t { free_list }; }
+    // Initializes whole generation blocks at a time
+    void init_generations(size_t count)
+    {
+        assert(count <= size());
+        while (generations_.size() * GenerationBlockSize < count) {
+            generations_.emplace_back(GenerationBlockSize, 0);
+        }
+    }
+
+    void clear_generations(size_t count)
+    {
+        for (size_t b = 0; b * GenerationBlockSize < count; ++b) {
+            detail::reset_generations(
+                generations_[b], std::min(GenerationBlockSize, count - b * GenerationBlockSize));
+        }
+    }
 
-    void store_element(size_t idx, T&& t)
+    template <typename... Args>
+    void emplace_element(size_t idx, Args&&... args)
     {
-        assert(generations_[idx] == 0);
+        assert(gen(idx) == 0);
         auto ptr = data(idx);
         reinterpret_cast<uint32_t*>(ptr)->~uint32_t();
-        new (ptr) T { std::move(t) };
+        new (ptr) T(std::forward<Args>(args)...);
     }
 
     void destroy_element(size_t idx, uint32_t free_list)
     {
-        assert(generations_[idx] > 0);
+        assert(gen(idx) > 0);
         auto ptr = data(idx);
         reinterpret_cast<T*>(ptr)->~T();
         new (ptr) uint32_t { free_list };
     }
 
-    auto size() const { return generations_.size(); }
+    auto size() const { return num_pages_ * page_size_; }
 
     T* data(size_t idx) { return reinterpret_cast<T*>(pages_[page_index(idx)] + elem_index(idx)); }
 
@@ -187,19 +384,316 @@ public:
         return *reinterpret_cast<const uint32_t*>(pages_[page_index(idx)] + elem_index(idx));
     };
 
-    GenerationType& gen(size_t idx) { return generations_[idx]; }
-    const GenerationType& gen(size_t idx) const { return generations_[idx]; }
+    GenerationType gen(size_t idx) const
+    {
+        return static_cast<GenerationType>(
+            generations_[idx / GenerationBlockSize][idx % GenerationBlockSize]);
+    }
+
+    void set_gen(size_t idx, GenerationType gen)
+    {
+        detail::set_generation(
+            generations_[idx / GenerationBlockSize], idx % GenerationBlockSize, gen);
+    }
+
+    GenerationType max_generation() const
+    {
+        return detail::max_generation<KeyType, GenerationStorage>();
+    }
+
+    void prefetch_gen(size_t idx) const
+    {
+        prefetch(detail::generation_address(
+            generations_[idx / GenerationBlockSize], idx % GenerationBlockSize));
+    }
+
+    // Stays valid until the storage is destroyed. Only if GenerationStorage stores addressable
+    // values (i.e. not for PackedGenerations).
+    auto gen_address(size_t idx) const
+        requires std::is_lvalue_reference_v<decltype(std::declval<const GenerationStorage&>()[0])>
+    {
+        return &generations_[idx / GenerationBlockSize][idx % GenerationBlockSize];
+    }
 
 private:
+    static constexpr size_t GenerationBlockSize = 1024;
+
     size_t page_index(size_t idx) const { return idx / page_size_; }
     size_t elem_index(size_t idx) const { return idx % page_size_; }
 
     ElementStorage<T>** pages_;
-    GenerationStorage generations_;
+    // One GenerationStorage per block of GenerationBlockSize slots that has been initialized
+    std::vector<GenerationStorage> generations_;
     Allocator<ElementStorage<T>> allocT_;
     Allocator<ElementStorage<T>*> allocP_;
     size_t page_size_;
     size_t num_pages_;
 };
 
-}
\ No newline at end of file
+// Like GrowableSlotMapStorage, but resize does not move the elements. It only allocates the new
+// buffers and every following emplace_element/destroy_element moves MigrationStep slots from the
+// old buffers to the new ones, so no single insert has to move the whole map (bounded latency
+// instead of best throughput). Lookups have to check which buffer a slot is in while a migration
+// is running. Generations are only zeroed when a slot is first used (init_generations is free).
+// Keep in mind:
+// * Pointers to elements are only stable until the next insert or remove (not just resize).
+// * Both sets of buffers are alive during a migration.
+// * A running migration is finished (all at once, O(n)) before the next resize. That never
+//   happens for a growth_factor of at least 2, because migrating a map of size n takes
+//   n / MigrationStep operations, but it might for smaller ones or explicit resize calls.
+// * The skipfield still resizes all at once, so use NullSkipfield or BitSkipfield (which is cheap
+//   to resize) if you care about latency.
+template <typename T, GenerationalIndex KeyType, template <typename> typename Allocator,
+    size_t MigrationStep = 64>
+struct IncrementalSlotMapStorage {
+public:
+    using GenerationType = KeyType::GenerationType;
+    using Element = T;
+
+    IncrementalSlotMapStorage(size_t capacity, const Allocator<ElementStorage<T>>& allocT = {},
+        const Allocator<GenerationType>& allocG = {})
+        : allocT_(allocT)
+        , allocG_(allocG)
+        , data_(allocT_.allocate(capacity))
+        , gens_(allocG_.allocate(capacity))
+        , capacity_(capacity)
+    {
+    }
+
+    // Every element HAS TO BE DESTROYED before the destructor is called, or we will get undefined
+    // behavior.
+    ~IncrementalSlotMapStorage()
+    {
+        allocT_.deallocate(data_, capacity_);
+        allocG_.deallocate(gens_, capacity_);
+        if (old_data_) {
+            allocT_.deallocate(old_data_, old_capacity_);
+            allocG_.deallocate(old_gens_, old_capacity_);
+        }
+    }
+
+    void resize(size_t size)
+    {
+        assert(size >= capacity_);
+        migrate(old_end_);
+        old_data_ = data_;
+        old_gens_ = gens_;
+        old_capacity_ = capacity_;
+        // Slots that were never used don't have to be migrated
+        old_end_ = zeroed_;
+        migrated_ = 0;
+        data_ = allocT_.allocate(size);
+        gens_ = allocG_.allocate(size);
+        capacity_ = size;
+        migrate(0);
+    }
+
+    // Generations are zeroed when the slot is first used (see set_gen)
+    void init_generations([[maybe_unused]] size_t count) { assert(count <= capacity_); }
+
+    // All slots are free now, so nothing is left to migrate and every generation can be zeroed
+    // lazily again, which makes this O(1).
+    void clear_generations([[maybe_unused]] size_t count)
+    {
+        assert(count <= zeroed_);
+        if (old_data_) {
+            allocT_.deallocate(old_data_, old_capacity_);
+            allocG_.deallocate(old_gens_, old_capacity_);
+            old_data_ = nullptr;
+            old_gens_ = nullptr;
+            old_capacity_ = 0;
+            old_end_ = 0;
+            migrated_ = 0;
+        }
+        zeroed_ = 0;
+    }
+
+    template <typename... Args>
+    void emplace_element(size_t idx, Args&&... args)
+    {
+        assert(gen(idx) == 0);
+        const auto ptr = element(idx);
+        reinterpret_cast<uint32_t*>(ptr)->~uint32_t();
+        new (ptr) T(std::forward<Args>(args)...);
+        // Only after constructing, because args might refer to an element that will be moved.
+        // The generation of idx is only set after this, so tell migrate it's occupied.
+        migrate(migrated_ + MigrationStep, idx);
+    }
+
+    void destroy_element(size_t idx, uint32_t free_list)
+    {
+        assert(gen(idx) > 0);
+        migrate(migrated_ + MigrationStep);
+        const auto ptr = element(idx);
+        reinterpret_cast<T*>(ptr)->~T();
+        new (ptr) uint32_t { free_list };
+    }
+
+    auto size() const { return capacity_; }
+
+    T* data(size_t idx) { return reinterpret_cast<T*>(element(idx)); }
+    const T* data(size_t idx) const { return reinterpret_cast<const T*>(element(idx)); }
+
+    uint32_t free_list(size_t idx) const
+    {
+        return *reinterpret_cast<const uint32_t*>(element(idx));
+    };
+
+    bool migrating() const { return old_data_ != nullptr; }
+
+    GenerationType gen(size_t idx) const { return idx < zeroed_ ? generation(idx) : 0; }
+
+    void set_gen(size_t idx, GenerationType gen)
+    {
+        // SlotMap uses new slots in order, so this only ever zeroes a few generations
+        for (; zeroed_ <= idx; ++zeroed_) {
+            generation(zeroed_) = 0;
+        }
+        generation(idx) = gen;
+    }
+
+    GenerationType max_generation() const
+    {
+        return detail::max_generation<KeyType, std::array<GenerationType, 1>>();
+    }
+
+    void prefetch_gen(size_t idx) const { prefetch(&generation(idx)); }
+
+private:
+    // [migrated_, old_end_) are still in the old buffers, everything else is in the new ones
+    bool in_old(size_t idx) const { return idx >= migrated_ && idx < old_end_; }
+
+    ElementStorage<T>* element(size_t idx) const
+    {
+        return in_old(idx) ? old_data_ + idx : data_ + idx;
+    }
+
+    GenerationType& generation(size_t idx) const
+    {
+        return in_old(idx) ? old_gens_[idx] : gens_[idx];
+    }
+
+    // Moves the slots up to end to the new buffers. occupied is a slot that already contains an
+    // element, but whose generation is still 0.
+    void migrate(size_t end, size_t occupied = std::numeric_limits<size_t>::max())
+    {
+        if (!old_data_) {
+            return;
+        }
+        end = std::min(end, old_end_);
+        for (; migrated_ < end; ++migrated_) {
+            const auto src = old_data_ + migrated_;
+            const auto dst = data_ + migrated_;
+            gens_[migrated_] = old_gens_[migrated_];
+            if (old_gens_[migrated_] > 0 || migrated_ == occupied) {
+                new (dst) T(std::move(*reinterpret_cast<T*>(src)));
+                reinterpret_cast<T*>(src)->~T();
+            } else {
+                // Might be a stale free list entry (after SlotMap::clear), which is never read
+                new (dst) uint32_t { *reinterpret_cast<const uint32_t*>(src) };
+            }
+        }
+        if (migrated_ == old_end_) {
+            allocT_.deallocate(old_data_, old_capacity_);
+            allocG_.deallocate(old_gens_, old_capacity_);
+            old_data_ = nullptr;
+            old_gens_ = nullptr;
+            old_capacity_ = 0;
+            old_end_ = 0;
+            migrated_ = 0;
+        }
+    }
+
+    Allocator<ElementStorage<T>> allocT_;
+    Allocator<GenerationType> allocG_;
+    ElementStorage<T>* data_;
+    GenerationType* gens_;
+    size_t capacity_;
+    ElementStorage<T>* old_data_ = nullptr;
+    GenerationType* old_gens_ = nullptr;
+    size_t old_capacity_ = 0;
+    size_t old_end_ = 0;
+    size_t migrated_ = 0;
+    // The generations of [0, zeroed_) have been written
+    size_t zeroed_ = 0;
+};
+
+// Keeps everything inside the object, so it doesn't allocate at all and it can be used in constant
+// expressions (all of SlotMap is constexpr). It can't grow, so capacity must be at most N.
+// Generations may be stored narrower than KeyType::GenerationType (e.g. uint8_t).
+template <typename T, GenerationalIndex KeyType, size_t N,
+    std::unsigned_integral GenerationInt = typename KeyType::GenerationType>
+struct InlineSlotMapStorage {
+public:
+    using GenerationType = KeyType::GenerationType;
+    using Element = T;
+
+    constexpr InlineSlotMapStorage([[maybe_unused]] size_t capacity) { assert(capacity <= N); }
+
+    constexpr void resize([[maybe_unused]] size_t size)
+    {
+        assert(size <= N && "InlineSlotMapStorage can't grow");
+    }
+
+    // The generations are zero-initialized on construction already
+    constexpr void init_generations([[maybe_unused]] size_t count) { assert(count <= N); }
+
+    constexpr void clear_generations(size_t count)
+    {
+        std::fill_n(generations_.begin(), count, GenerationInt(0));
+    }
+
+    template <typename... Args>
+    constexpr void emplace_element(size_t idx, Args&&... args)
+    {
+        assert(generations_[idx] == 0);
+        std::construct_at(&slots_[idx].element, std::forward<Args>(args)...);
+    }
+
+    constexpr void destroy_element(size_t idx, uint32_t free_list)
+    {
+        assert(generations_[idx] > 0);
+        std::destroy_at(&slots_[idx].element);
+        std::construct_at(&slots_[idx].free_list, free_list);
+    }
+
+    constexpr size_t size() const { return N; }
+
+    constexpr T* data(size_t idx) { return &slots_[idx].element; }
+    constexpr const T* data(size_t idx) const { return &slots_[idx].element; }
+
+    constexpr uint32_t free_list(size_t idx) const { return slots_[idx].free_list; }
+
+    constexpr GenerationType gen(size_t idx) const
+    {
+        return static_cast<GenerationType>(generations_[idx]);
+    }
+
+    constexpr void set_gen(size_t idx, GenerationType gen)
+    {
+        generations_[idx] = static_cast<GenerationInt>(gen);
+    }
+
+    constexpr GenerationType max_generation() const
+    {
+        return detail::max_generation<KeyType, std::array<GenerationInt, N>>();
+    }
+
+    void prefetch_gen(size_t idx) const { prefetch(&generations_[idx]); }
+
+private:
+    // A union, because reinterpret_cast is not allowed in constant expressions
+    union Slot {
+        constexpr Slot() : free_list(0) { }
+        // The element (if any) is destroyed by SlotMap
+        constexpr ~Slot() { }
+
+        uint32_t free_list;
+        T element;
+    };
+
+    std::array<Slot, N> slots_ {};
+    std::array<GenerationInt, N> generations_ {};
+};
+
+}
@@ -4,6 +4,8 @@
 #include <type_traits>
 #include <vector>
 
+#include "dynamic_bitset.hpp"
+
 namespace pasta {
 
 template <typename T>
@@ -14,16 +16,14 @@ public:
     SparseVector(size_t size)
         : data_(alloc(size))
         , size_(size)
-        , occupied_(size, 0)
+        , occupied_(size)
     {
     }
 
     ~SparseVector()
     {
-        for (size_t i = 0; i < size_; ++i) {
-            if (occupied_[i]) {
-                erase(i);
-            }
+        for (const auto i : occupied_.set_bits()) {
+            erase(i);
         }
         operator delete(data_, std::align_val_t(alignof(T)));
     }
@@ -42,16 +42,14 @@ public:
     {
         assert(size > size_);
         auto newData = alloc(size);
-        for (size_t i = 0; i < size_; ++i) {
-            if (occupied_[i]) {
-                new (newData + i) T { std::move(data_[i]) };
-                data_[i].~T();
-            }
+        for (const auto i : occupied_.set_bits()) {
+            new (newData + i) T { std::move(data_[i]) };
+            data_[i].~T();
         }
         operator delete(data_, std::align_val_t(alignof(T)));
         data_ = newData;
         size_ = size;
-        occupied_.resize(size, 0);
+        occupied_.resize(size);
     }
 
     void insert(size_t index, const T& v)
@@ -70,7 +68,7 @@ public:
         assert(index < size_);
         assert(!contains(index));
         new (&data_[index]) T { std::forward<Args>(args)... };
-        occupied_[index] = 1;
+        occupied_.set(index);
         numOccupied_++;
         return data_[index];
     }
@@ -84,7 +82,7 @@ public:
     {
         assert(contains(index));
         data_[index].~T();
-        occupied_[index] = 0;
+        occupied_.reset(index);
         numOccupied_--;
     }
 
@@ -119,7 +117,7 @@ private:
     T* data_ = nullptr;
     size_t size_ = 0;
     size_t numOccupied_ = 0;
-    std::vector<uint8_t> occupied_;
+    DynamicBitset occupied_;
 };
 
 }
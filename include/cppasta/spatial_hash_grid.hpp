@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "generational_index.hpp"
+
+/* SpatialHashGrid
+
+A uniform grid for neighbour queries over many moving points that is rebuilt from scratch every
+frame (which is usually faster than updating it incrementally if most things move).
+
+The plane is divided into square cells of size cell_size. Cells are hashed into a power of two
+number of buckets (about one per point, chosen on every rebuild), so the grid is unbounded, and
+rebuilding is a counting sort of all points by bucket: count the points per bucket, compute the
+prefix sum, then scatter the points into one contiguous array. There are no per-cell allocations
+and all points of a cell are adjacent in memory. All buffers are reused between rebuilds, so after
+the first few frames rebuilding doesn't allocate.
+
+The grid stores generational keys (e.g. from a SlotMap or DenseSlotMap), a copy of the position
+and the cell of every point, so queries don't have to look up the objects themselves and can tell
+apart cells that share a bucket.
+
+Cell coordinates are clamped to +-2^30, so points very far from the origin share the outermost
+cells. A query visits every cell its box overlaps, unless that is more cells than there are
+points, in which case it checks every point instead.
+
+A good cell size is about the most common query radius. Only points are stored; for objects with
+an extent, add the maximum extent to the query radius.
+*/
+
+namespace pasta {
+
+template <GenerationalIndex Key>
+class SpatialHashGrid {
+public:
+    struct Point {
+        float x;
+        float y;
+    };
+
+    struct Entry {
+        Key key;
+        Point pos;
+        int32_t cell_x;
+        int32_t cell_y;
+    };
+
+    SpatialHashGrid(float cell_size) : cell_size_(cell_size), inv_cell_size_(1.0f / cell_size)
+    {
+        assert(cell_size > 0.0f);
+    }
+
+    void rebuild(std::span<const Key> keys, std::span<const Point> positions)
+    {
+        assert(keys.size() == positions.size());
+        begin_rebuild(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            add(i, keys[i], positions[i]);
+        }
+        end_rebuild();
+    }
+
+    // Rebuilds from a structure of arrays
+    void rebuild(std::span<const Key> keys, std::span<const float> xs, std::span<const float> ys)
+    {
+        assert(keys.size() == xs.size() && keys.size() == ys.size());
+        begin_rebuild(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            add(i, keys[i], Point { xs[i], ys[i] });
+        }
+        end_rebuild();
+    }
+
+    // Rebuilds from every element of a DenseSlotMap. get_pos(const Value&) has to return something
+    // that can be converted to Point.
+    template <typename Map, typename PosFunc>
+    void rebuild_from(const Map& map, PosFunc&& get_pos)
+    {
+        begin_rebuild(map.size());
+        size_t i = 0;
+        for (const auto& elem : map) {
+            add(i++, map.get_key(&elem), Point(get_pos(elem)));
+        }
+        end_rebuild();
+    }
+
+    // Calls func(const Entry&) for every point inside the axis aligned box (inclusive)
+    template <typename Func>
+    void for_each_in_aabb(Point min, Point max, Func&& func) const
+    {
+        if (entries_.empty()) {
+            return;
+        }
+        const auto min_x = cell_coord(min.x), min_y = cell_coord(min.y);
+        const auto max_x = cell_coord(max.x), max_y = cell_coord(max.y);
+        if (max_x < min_x || max_y < min_y) {
+            return;
+        }
+        // If the box covers more cells than there are points, walking the cells costs more than
+        // simply checking every point (and a huge box would take practically forever).
+        const auto num_cells = (static_cast<uint64_t>(max_x - min_x) + 1)
+            * (static_cast<uint64_t>(max_y - min_y) + 1);
+        if (num_cells > entries_.size()) {
+            for (const auto& e : entries_) {
+                if (e.pos.x >= min.x && e.pos.x <= max.x && e.pos.y >= min.y && e.pos.y <= max.y) {
+                    func(e);
+                }
+            }
+            return;
+        }
+        for (auto cy = min_y; cy <= max_y; ++cy) {
+            for (auto cx = min_x; cx <= max_x; ++cx) {
+                const auto bucket = bucket_index(cx, cy);
+                for (auto i = bucket_start_[bucket]; i < bucket_start_[bucket + 1]; ++i) {
+                    const auto& e = entries_[i];
+                    // Other cells might hash to the same bucket
+                    if (e.cell_x == cx && e.cell_y == cy && e.pos.x >= min.x && e.pos.x <= max.x
+                        && e.pos.y >= min.y && e.pos.y <= max.y) {
+                        func(e);
+                    }
+                }
+            }
+        }
+    }
+
+    // Calls func(const Entry&) for every point with a distance <= radius
+    template <typename Func>
+    void for_each_in_radius(Point center, float radius, Func&& func) const
+    {
+        const auto r2 = radius * radius;
+        for_each_in_aabb(Point { center.x - radius, center.y - radius },
+            Point { center.x + radius, center.y + radius }, [&](const Entry& e) {
+                const auto dx = e.pos.x - center.x, dy = e.pos.y - center.y;
+                if (dx * dx + dy * dy <= r2) {
+                    func(e);
+                }
+            });
+    }
+
+    // These append to out
+    void query_aabb(Point min, Point max, std::vector<Key>& out) const
+    {
+        for_each_in_aabb(min, max, [&out](const Entry& e) { out.push_back(e.key); });
+    }
+
+    void query_radius(Point center, float radius, std::vector<Key>& out) const
+    {
+        for_each_in_radius(center, radius, [&out](const Entry& e) { out.push_back(e.key); });
+    }
+
+    size_t size() const { return entries_.size(); }
+    float cell_size() const { return cell_size_; }
+
+    // Sorted by bucket
+    const std::vector<Entry>& entries() const { return entries_; }
+
+private:
+    // Far enough from the int32_t limits that the conversion can't overflow and the cell loops in
+    // for_each_in_aabb can't wrap around. Points further out share the outermost cells.
+    static constexpr float MaxCell = static_cast<float>(1 << 30);
+
+    int32_t cell_coord(float v) const
+    {
+        // Written so NaN ends up as MaxCell (every comparison with NaN is false)
+        const auto c = std::floor(v * inv_cell_size_);
+        return static_cast<int32_t>(c > -MaxCell ? (c < MaxCell ? c : MaxCell) : -MaxCell);
+    }
+
+    uint32_t bucket_index(int32_t cx, int32_t cy) const
+    {
+        // From "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+        const auto h
+            = (static_cast<uint32_t>(cx) * 73856093u) ^ (static_cast<uint32_t>(cy) * 19349663u);
+        return h & bucket_mask_;
+    }
+
+    void begin_rebuild(size_t count)
+    {
+        // About one bucket per point
+        const auto num_buckets = std::bit_ceil(std::max<size_t>(count, 1));
+        bucket_mask_ = static_cast<uint32_t>(num_buckets - 1);
+        bucket_start_.assign(num_buckets + 1, 0);
+        unsorted_.resize(count);
+        entries_.resize(count);
+    }
+
+    void add(size_t i, Key key, Point pos)
+    {
+        const auto cx = cell_coord(pos.x), cy = cell_coord(pos.y);
+        unsorted_[i] = Entry { key, pos, cx, cy };
+        // Count into the next bucket, so the prefix sum gives us the start of every bucket
+        bucket_start_[bucket_index(cx, cy) + 1]++;
+    }
+
+    void end_rebuild()
+    {
+        for (size_t b = 1; b < bucket_start_.size(); ++b) {
+            bucket_start_[b] += bucket_start_[b - 1];
+        }
+        // Use the starts as write cursors and restore them afterwards, which saves a separate
+        // cursor array.
+        for (const auto& e : unsorted_) {
+            entries_[bucket_start_[bucket_index(e.cell_x, e.cell_y)]++] = e;
+        }
+        for (size_t b = bucket_start_.size() - 1; b > 0; --b) {
+            bucket_start_[b] = bucket_start_[b - 1];
+        }
+        bucket_start_[0] = 0;
+    }
+
+    float cell_size_;
+    float inv_cell_size_;
+    uint32_t bucket_mask_ = 0;
+    std::vector<uint32_t> bucket_start_; // num_buckets + 1 entries
+    std::vector<Entry> unsorted_;
+    std::vector<Entry> entries_;
+};
+
+}
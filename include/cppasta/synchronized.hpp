@@ -1,10 +1,22 @@
 #pragma once
 
 #include <mutex>
+#include <utility>
 
 namespace pasta {
 
-template <typename Data>
+/*
+ * Mutex can be anything with lock/unlock (e.g. std::mutex or a spin lock).
+ * If it also has lock_shared/unlock_shared (e.g. std::shared_mutex), the const lock handles
+ * acquire a shared lock, so readers don't block each other.
+ */
+template <typename Mutex>
+concept SharedLockable = requires(Mutex& m) {
+    m.lock_shared();
+    m.unlock_shared();
+};
+
+template <typename Data, typename Mutex = std::mutex>
 class Synchronized
 {
 public:
@@ -18,10 +30,7 @@ public:
 
         ~ConstLockHandle()
         {
-            if (synchronized_)
-            {
-                synchronized_->mutex_.unlock();
-            }
+            unlock();
         }
 
         // We can only have one Synchronized object (or we might unlock twice).
@@ -37,8 +46,10 @@ public:
 
         ConstLockHandle& operator=(ConstLockHandle&& other)
         {
+            unlock();
             synchronized_ = other.synchronized_;
             other.synchronized_ = nullptr;
+            return *this;
         }
 
         const Data* operator->() const
@@ -70,6 +81,14 @@ public:
         }
 
     private:
+        void unlock()
+        {
+            if (synchronized_)
+            {
+                synchronized_->unlockConst();
+            }
+        }
+
         const Synchronized* synchronized_;
     };
 
@@ -83,10 +102,7 @@ public:
 
         ~LockHandle()
         {
-            if (synchronized_)
-            {
-                synchronized_->mutex_.unlock();
-            }
+            unlock();
         }
 
         LockHandle(const LockHandle&) = delete;
@@ -100,8 +116,10 @@ public:
 
         LockHandle& operator=(LockHandle&& other)
         {
+            unlock();
             synchronized_ = other.synchronized_;
             other.synchronized_ = nullptr;
+            return *this;
         }
 
         const Data* operator->() const
@@ -145,6 +163,14 @@ public:
         }
 
     private:
+        void unlock()
+        {
+            if (synchronized_)
+            {
+                synchronized_->mutex_.unlock();
+            }
+        }
+
         Synchronized* synchronized_;
     };
 
@@ -170,18 +196,36 @@ public:
 
     ConstLockHandle lock() const
     {
-        mutex_.lock();
-        return ConstLockHandle(this);
+        return lockConst();
     }
 
     ConstLockHandle lockConst() const
     {
-        mutex_.lock();
+        if constexpr (SharedLockable<Mutex>)
+        {
+            mutex_.lock_shared();
+        }
+        else
+        {
+            mutex_.lock();
+        }
         return ConstLockHandle(this);
     }
 
 private:
-    mutable std::mutex mutex_;
+    void unlockConst() const
+    {
+        if constexpr (SharedLockable<Mutex>)
+        {
+            mutex_.unlock_shared();
+        }
+        else
+        {
+            mutex_.unlock();
+        }
+    }
+
+    mutable Mutex mutex_;
     Data data_;
 };
 
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* ThreadPool
+
+A fixed set of worker threads for data parallel work (see parallel.hpp). There is no task queue:
+run(num_chunks, func) calls func(chunk) for every chunk index, distributed dynamically over the
+workers and the calling thread, and returns when all chunks are done. Which thread runs which
+chunk is unspecified, so results must only depend on the chunk index.
+
+Concurrent run() calls from different threads are executed one after another. Nested calls (run()
+from inside a chunk) are executed serially on the calling thread, so they can't deadlock.
+If a chunk throws, the remaining chunks are still executed and the first exception is rethrown
+from run().
+*/
+
+namespace pasta {
+
+class ThreadPool {
+public:
+    // The calling thread helps executing chunks, so by default there is one worker less than there
+    // are hardware threads.
+    explicit ThreadPool(size_t num_workers = default_num_workers());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void run(size_t num_chunks, const std::function<void(size_t)>& func);
+
+    size_t num_workers() const { return workers_.size(); }
+
+    static size_t default_num_workers();
+
+private:
+    struct Job {
+        const std::function<void(size_t)>* func;
+        size_t num_chunks;
+        std::atomic<size_t> next_chunk { 0 };
+        std::mutex exception_mutex;
+        std::exception_ptr exception;
+    };
+
+    void worker();
+    static void execute(Job& job);
+
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_; // only one run at a time
+    std::mutex mutex_; // protects everything below
+    std::condition_variable job_cv_;
+    std::condition_variable done_cv_;
+    Job* job_ = nullptr;
+    uint64_t generation_ = 0;
+    size_t num_active_ = 0;
+    bool stop_ = false;
+};
+
+// A global pool with the default number of workers, created on first use
+ThreadPool& getThreadPool();
+
+}
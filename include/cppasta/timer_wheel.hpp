@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "generational_index.hpp"
+#include "slot_map.hpp"
+
+/* TimerWheel
+
+A hierarchical timing wheel (Varghese & Lauck) for very many timers, most of which are cancelled
+or rescheduled before they expire (e.g. connection timeouts).
+
+Time is measured in integer ticks. Level 0 has one bucket per tick for the next 2^SlotBits ticks.
+Every bucket of level 1 covers 2^SlotBits ticks, every bucket of level 2 covers 2^(2 * SlotBits)
+ticks and so on. A timer is put in the lowest level that can represent its delay. Whenever level 0
+wraps around, the next bucket of level 1 is cascaded, i.e. all timers in it are redistributed into
+level 0 (and likewise for the higher levels). Timers that are further in the future than the top
+level can represent are kept in the top level and are redistributed until they fit.
+
+Scheduling, cancelling and rescheduling are O(1). Every timer is cascaded at most NumLevels - 1
+times.
+
+The timers are stored in a SlotMap and the buckets are intrusive doubly linked lists, linked by
+slot map keys. Those keys are handed out as timer handles, so cancelling a timer that has already
+expired (or was cancelled) is a no-op, even if its slot has been reused in the meantime.
+*/
+
+namespace pasta {
+
+template <typename Payload, GenerationalIndex KeyType = CompositeId<Payload>, size_t SlotBits = 8,
+    size_t NumLevels = 4>
+class TimerWheel {
+    static_assert(SlotBits * NumLevels < 64);
+
+public:
+    using Key = KeyType;
+
+    TimerWheel(size_t capacity = 1024, uint64_t now = 0)
+        : timers_(capacity, 64, 2.0f)
+        , now_(now)
+    {
+    }
+
+    // Timers that are due in the current tick (delay = 0) will fire on the next tick.
+    Key schedule(uint64_t delay, Payload payload)
+    {
+        return schedule_at(now_ + delay, std::move(payload));
+    }
+
+    Key schedule_at(uint64_t tick, Payload payload)
+    {
+        const auto key = timers_.insert(Timer { std::move(payload), std::max(tick, now_ + 1) });
+        link(key);
+        return key;
+    }
+
+    // Returns false if the timer already expired or was cancelled
+    bool cancel(Key key)
+    {
+        if (!timers_.contains(key)) {
+            return false;
+        }
+        unlink(key);
+        timers_.remove(key);
+        return true;
+    }
+
+    // Like cancel and schedule, but keeps the key and doesn't move the payload
+    bool reschedule(Key key, uint64_t delay)
+    {
+        if (!timers_.contains(key)) {
+            return false;
+        }
+        unlink(key);
+        timers_.get(key)->expiry = std::max(now_ + delay, now_ + 1);
+        link(key);
+        return true;
+    }
+
+    bool contains(Key key) const { return timers_.contains(key); }
+
+    Payload* find(Key key)
+    {
+        const auto timer = timers_.find(key);
+        return timer ? &timer->payload : nullptr;
+    }
+
+    // Returns the tick at which the timer will expire
+    uint64_t expiry(Key key) const
+    {
+        assert(contains(key));
+        return timers_.get(key)->expiry;
+    }
+
+    // Processes the next `ticks` ticks and calls func(Payload&&) for every expired timer.
+    // The timer is removed before func is called, so func may schedule or cancel timers freely.
+    // Returns the number of expired timers.
+    template <typename Func>
+    size_t advance(uint64_t ticks, Func&& func)
+    {
+        size_t num_expired = 0;
+        for (uint64_t i = 0; i < ticks; ++i) {
+            if (timers_.size() == 0) {
+                now_ += ticks - i;
+                break;
+            }
+            num_expired += tick(func);
+        }
+        return num_expired;
+    }
+
+    // Processes all ticks up to and including `tick`
+    template <typename Func>
+    size_t advance_to(uint64_t tick, Func&& func)
+    {
+        return tick > now_ ? advance(tick - now_, std::forward<Func>(func)) : 0;
+    }
+
+    // The last tick that was processed
+    uint64_t now() const { return now_; }
+
+    size_t size() const { return timers_.size(); }
+
+private:
+    static constexpr size_t NumSlots = size_t(1) << SlotBits;
+    static constexpr uint64_t SlotMask = NumSlots - 1;
+    static constexpr size_t NumBuckets = NumLevels * NumSlots;
+    // Timers that are about to be expired are moved into a separate list, so that timers scheduled
+    // from the callbacks don't end up in the list that is being processed.
+    static constexpr size_t ExpiringBucket = NumBuckets;
+
+    struct Timer {
+        Payload payload;
+        uint64_t expiry;
+        Key prev = Key();
+        Key next = Key();
+        uint32_t bucket = 0;
+    };
+
+    template <typename T, typename K>
+    using Storage = GrowableSlotMapStorage<T, K, std::vector<typename K::GenerationType>,
+        std::allocator>;
+
+    static constexpr uint64_t level_shift(size_t level) { return level * SlotBits; }
+
+    size_t bucket_for(uint64_t expiry) const
+    {
+        assert(expiry >= now_);
+        const auto delta = expiry - now_;
+        size_t level = 0;
+        while (level + 1 < NumLevels && delta >= (uint64_t(1) << level_shift(level + 1))) {
+            level++;
+        }
+        return level * NumSlots + ((expiry >> level_shift(level)) & SlotMask);
+    }
+
+    void push_front(size_t bucket, Key key)
+    {
+        auto& timer = *timers_.get(key);
+        timer.bucket = static_cast<uint32_t>(bucket);
+        timer.prev = Key();
+        timer.next = buckets_[bucket];
+        if (buckets_[bucket]) {
+            timers_.get(buckets_[bucket])->prev = key;
+        }
+        buckets_[bucket] = key;
+    }
+
+    void link(Key key) { push_front(bucket_for(timers_.get(key)->expiry), key); }
+
+    void unlink(Key key)
+    {
+        auto& timer = *timers_.get(key);
+        if (timer.prev) {
+            timers_.get(timer.prev)->next = timer.next;
+        } else {
+            buckets_[timer.bucket] = timer.next;
+        }
+        if (timer.next) {
+            timers_.get(timer.next)->prev = timer.prev;
+        }
+    }
+
+    // Takes the whole list out of the bucket
+    Key take(size_t bucket) { return std::exchange(buckets_[bucket], Key()); }
+
+    void cascade(size_t level)
+    {
+        auto key = take(level * NumSlots + ((now_ >> level_shift(level)) & SlotMask));
+        while (key) {
+            const auto next = timers_.get(key)->next;
+            link(key);
+            key = next;
+        }
+    }
+
+    template <typename Func>
+    size_t tick(Func& func)
+    {
+        now_++;
+        // Cascade from the top, so timers can trickle down multiple levels in one tick
+        for (size_t level = NumLevels - 1; level > 0; --level) {
+            if ((now_ & ((uint64_t(1) << level_shift(level)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+
+        auto key = take(now_ & SlotMask);
+        while (key) {
+            const auto next = timers_.get(key)->next;
+            push_front(ExpiringBucket, key);
+            key = next;
+        }
+
+        size_t num_expired = 0;
+        while (buckets_[ExpiringBucket]) {
+            const auto key = buckets_[ExpiringBucket];
+            unlink(key);
+            auto payload = std::move(timers_.get(key)->payload);
+            assert(timers_.get(key)->expiry == now_);
+            timers_.remove(key);
+            func(std::move(payload));
+            num_expired++;
+        }
+        return num_expired;
+    }
+
+    SlotMap<Timer, Storage, Key> timers_;
+    std::array<Key, NumBuckets + 1> buckets_ {};
+    uint64_t now_ = 0;
+};
+
+}
@@ -1,8 +1,13 @@
+#pragma once
+
+#include <algorithm>
 #include <cassert>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include "iterators.hpp"
+#include "random.hpp"
 
 namespace pasta {
 
@@ -73,12 +78,10 @@ public:
     RandomView(Container& container)
         : m_container(container)
     {
-        static std::random_device seed;
-        static std::default_random_engine rng(seed());
         m_indices.reserve(m_container.size());
         for (size_t i = 0; i < m_container.size(); ++i)
             m_indices.push_back(i);
-        std::shuffle(m_indices.begin(), m_indices.end(), rng);
+        std::shuffle(m_indices.begin(), m_indices.end(), getRng());
     }
 
     reference operator[](size_t index) const
@@ -114,8 +117,7 @@ public:
 
     reference operator[](size_t index) const
     {
-        LOG_ASSERT(index < m_rows, "Index (index = {}) out of range (rows = {}) for MatrixView",
-            index, m_rows);
+        assert(index < m_rows);
         return RangeView<Container>(m_container, index * m_columns, m_columns);
     }
 
@@ -147,7 +149,7 @@ public:
 
     reference operator[](size_t index) const
     {
-        LOG_ASSERT(index < size(), "Index ({}) out of range ({})", index, size());
+        assert(index < size());
         return reference(index, m_container[index]);
     }
 
@@ -0,0 +1,295 @@
+#include "cppasta/dynamic_bitset.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace pasta {
+
+namespace {
+    enum class BitOp { And, Or, Xor, AndNot };
+
+    template <BitOp Op>
+    uint64_t apply(uint64_t a, uint64_t b)
+    {
+        if constexpr (Op == BitOp::And) {
+            return a & b;
+        } else if constexpr (Op == BitOp::Or) {
+            return a | b;
+        } else if constexpr (Op == BitOp::Xor) {
+            return a ^ b;
+        } else {
+            return a & ~b;
+        }
+    }
+
+    // a = a op b
+    template <BitOp Op>
+    void bitwise(uint64_t* a, const uint64_t* b, size_t n)
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 4 <= n; i += 4) {
+            const auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i r;
+            if constexpr (Op == BitOp::And) {
+                r = _mm256_and_si256(va, vb);
+            } else if constexpr (Op == BitOp::Or) {
+                r = _mm256_or_si256(va, vb);
+            } else if constexpr (Op == BitOp::Xor) {
+                r = _mm256_xor_si256(va, vb);
+            } else {
+                r = _mm256_andnot_si256(vb, va);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), r);
+        }
+#elif defined(__SSE2__)
+        for (; i + 2 <= n; i += 2) {
+            const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i r;
+            if constexpr (Op == BitOp::And) {
+                r = _mm_and_si128(va, vb);
+            } else if constexpr (Op == BitOp::Or) {
+                r = _mm_or_si128(va, vb);
+            } else if constexpr (Op == BitOp::Xor) {
+                r = _mm_xor_si128(va, vb);
+            } else {
+                r = _mm_andnot_si128(vb, va);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), r);
+        }
+#endif
+        for (; i < n; ++i) {
+            a[i] = apply<Op>(a[i], b[i]);
+        }
+    }
+
+#if defined(__AVX2__)
+    // Popcount of every 64-bit lane with a 4-bit lookup table (Mula, Kurz, Lemire: "Faster
+    // Population Counts Using AVX2 Instructions")
+    __m256i popcount256(__m256i v)
+    {
+        const auto lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+            1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const auto low_mask = _mm256_set1_epi8(0x0f);
+        const auto lo = _mm256_and_si256(v, low_mask);
+        const auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+        const auto counts = _mm256_add_epi8(
+            _mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+        return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+    }
+#endif
+
+    size_t popcount(const uint64_t* words, size_t n)
+    {
+        size_t i = 0;
+        size_t count = 0;
+#if defined(__AVX2__)
+        auto acc = _mm256_setzero_si256();
+        for (; i + 4 <= n; i += 4) {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+            acc = _mm256_add_epi64(acc, popcount256(v));
+        }
+        count += static_cast<size_t>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+            + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+#endif
+        for (; i < n; ++i) {
+            count += static_cast<size_t>(std::popcount(words[i]));
+        }
+        return count;
+    }
+
+    // Returns the index of the first word >= start that is not equal to skip (0 or ~0) or n
+    size_t find_word(const uint64_t* words, size_t start, size_t n, uint64_t skip)
+    {
+        size_t i = start;
+#if defined(__AVX2__)
+        const auto skip_v = _mm256_set1_epi64x(static_cast<long long>(skip));
+        for (; i + 4 <= n; i += 4) {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+            const auto eq = _mm256_cmpeq_epi64(v, skip_v);
+            if (_mm256_movemask_epi8(eq) != -1) {
+                break;
+            }
+        }
+#endif
+        while (i < n && words[i] == skip) {
+            i++;
+        }
+        return i;
+    }
+}
+
+DynamicBitset::DynamicBitset(size_t size, bool value)
+    : words_(num_words(size), value ? ~uint64_t(0) : 0)
+    , size_(size)
+{
+    clear_padding();
+}
+
+void DynamicBitset::resize(size_t size, bool value)
+{
+    const auto old_size = size_;
+    words_.resize(num_words(size), value ? ~uint64_t(0) : 0);
+    size_ = size;
+    if (value && size > old_size) {
+        // The padding of the old last word is zero
+        set_range(old_size, std::min(size, num_words(old_size) * 64));
+    }
+    clear_padding();
+}
+
+void DynamicBitset::clear()
+{
+    words_.clear();
+    size_ = 0;
+}
+
+void DynamicBitset::set()
+{
+    std::fill(words_.begin(), words_.end(), ~uint64_t(0));
+    clear_padding();
+}
+
+void DynamicBitset::reset()
+{
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+void DynamicBitset::flip()
+{
+    for (auto& w : words_) {
+        w = ~w;
+    }
+    clear_padding();
+}
+
+void DynamicBitset::set_range(size_t begin, size_t end)
+{
+    assert(begin <= end && end <= size_);
+    if (begin == end) {
+        return;
+    }
+    const auto first = begin / 64, last = (end - 1) / 64;
+    const auto first_mask = ~uint64_t(0) << (begin % 64);
+    const auto last_mask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+    if (first == last) {
+        words_[first] |= first_mask & last_mask;
+        return;
+    }
+    words_[first] |= first_mask;
+    std::fill(words_.begin() + first + 1, words_.begin() + last, ~uint64_t(0));
+    words_[last] |= last_mask;
+}
+
+void DynamicBitset::reset_range(size_t begin, size_t end)
+{
+    assert(begin <= end && end <= size_);
+    if (begin == end) {
+        return;
+    }
+    const auto first = begin / 64, last = (end - 1) / 64;
+    const auto first_mask = ~uint64_t(0) << (begin % 64);
+    const auto last_mask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+    if (first == last) {
+        words_[first] &= ~(first_mask & last_mask);
+        return;
+    }
+    words_[first] &= ~first_mask;
+    std::fill(words_.begin() + first + 1, words_.begin() + last, 0);
+    words_[last] &= ~last_mask;
+}
+
+size_t DynamicBitset::count() const
+{
+    return popcount(words_.data(), words_.size());
+}
+
+bool DynamicBitset::any() const
+{
+    return find_word(words_.data(), 0, words_.size(), 0) < words_.size();
+}
+
+bool DynamicBitset::all() const
+{
+    return find_next_unset(0) == npos;
+}
+
+size_t DynamicBitset::find_next_set(size_t pos) const
+{
+    if (pos >= size_) {
+        return npos;
+    }
+    auto w = pos / 64;
+    const auto word = words_[w] & (~uint64_t(0) << (pos % 64));
+    if (word) {
+        return w * 64 + static_cast<size_t>(std::countr_zero(word));
+    }
+    w = find_word(words_.data(), w + 1, words_.size(), 0);
+    if (w == words_.size()) {
+        return npos;
+    }
+    return w * 64 + static_cast<size_t>(std::countr_zero(words_[w]));
+}
+
+size_t DynamicBitset::find_next_unset(size_t pos) const
+{
+    if (pos >= size_) {
+        return npos;
+    }
+    auto w = pos / 64;
+    auto word = ~words_[w] & (~uint64_t(0) << (pos % 64));
+    if (!word) {
+        w = find_word(words_.data(), w + 1, words_.size(), ~uint64_t(0));
+        if (w == words_.size()) {
+            return npos;
+        }
+        word = ~words_[w];
+    }
+    // The padding is unset, so we might find a bit past the end
+    const auto idx = w * 64 + static_cast<size_t>(std::countr_zero(word));
+    return idx < size_ ? idx : npos;
+}
+
+DynamicBitset& DynamicBitset::operator&=(const DynamicBitset& other)
+{
+    assert(size_ == other.size_);
+    bitwise<BitOp::And>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+DynamicBitset& DynamicBitset::operator|=(const DynamicBitset& other)
+{
+    assert(size_ == other.size_);
+    bitwise<BitOp::Or>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+DynamicBitset& DynamicBitset::operator^=(const DynamicBitset& other)
+{
+    assert(size_ == other.size_);
+    bitwise<BitOp::Xor>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+DynamicBitset& DynamicBitset::operator-=(const DynamicBitset& other)
+{
+    assert(size_ == other.size_);
+    bitwise<BitOp::AndNot>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+void DynamicBitset::clear_padding()
+{
+    if (size_ % 64 != 0) {
+        words_.back() &= ~uint64_t(0) >> (64 - size_ % 64);
+    }
+}
+
+}
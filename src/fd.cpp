@@ -59,7 +59,8 @@ int Fd::release()
 Pipe::Pipe()
 {
     int fds[2];
-    assert(pipe(fds) != -1);
+    [[maybe_unused]] const auto res = pipe(fds);
+    assert(res != -1);
     read.reset(fds[0]);
     write.reset(fds[1]);
 }
@@ -2,9 +2,9 @@
 
 namespace pasta {
 
-std::default_random_engine& getRng()
+RngEngine& getRng()
 {
-    static std::default_random_engine rng { std::random_device {}() };
+    static RngEngine rng { std::random_device {}() };
     return rng;
 }
 }
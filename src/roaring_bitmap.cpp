@@ -0,0 +1,955 @@
+#include "cppasta/roaring_bitmap.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace pasta {
+
+namespace {
+    using Container = detail::RoaringContainer;
+    using Type = Container::Type;
+
+    constexpr auto MaxArraySize = Container::MaxArraySize;
+    constexpr auto BitmapWords = Container::BitmapWords;
+
+    bool bitmap_test(const std::vector<uint64_t>& words, uint16_t v)
+    {
+        return (words[v >> 6] >> (v & 63)) & 1;
+    }
+
+    void bitmap_set(std::vector<uint64_t>& words, uint16_t v)
+    {
+        words[v >> 6] |= uint64_t(1) << (v & 63);
+    }
+
+    uint32_t bitmap_count(const std::vector<uint64_t>& words)
+    {
+        uint32_t count = 0;
+        for (const auto w : words) {
+            count += static_cast<uint32_t>(std::popcount(w));
+        }
+        return count;
+    }
+
+    // Sets [begin, end), end <= 65536
+    void bitmap_set_range(std::vector<uint64_t>& words, uint32_t begin, uint32_t end)
+    {
+        if (begin >= end) {
+            return;
+        }
+        const auto first = begin >> 6, last = (end - 1) >> 6;
+        const auto first_mask = ~uint64_t(0) << (begin & 63);
+        const auto last_mask = ~uint64_t(0) >> (63 - ((end - 1) & 63));
+        if (first == last) {
+            words[first] |= first_mask & last_mask;
+            return;
+        }
+        words[first] |= first_mask;
+        for (auto w = first + 1; w < last; ++w) {
+            words[w] = ~uint64_t(0);
+        }
+        words[last] |= last_mask;
+    }
+
+    enum class BitOp { Or, And, AndNot };
+
+    // a = a op b, returns the cardinality of the result
+    template <BitOp Op>
+    uint32_t bitmap_op(std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+    {
+        assert(a.size() == BitmapWords && b.size() == BitmapWords);
+        uint32_t count = 0;
+#if defined(__SSE2__)
+        static_assert(BitmapWords % 2 == 0);
+        for (size_t i = 0; i < BitmapWords; i += 2) {
+            const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i));
+            const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + i));
+            __m128i r;
+            if constexpr (Op == BitOp::Or) {
+                r = _mm_or_si128(va, vb);
+            } else if constexpr (Op == BitOp::And) {
+                r = _mm_and_si128(va, vb);
+            } else {
+                r = _mm_andnot_si128(vb, va);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a.data() + i), r);
+            count += static_cast<uint32_t>(std::popcount(a[i]) + std::popcount(a[i + 1]));
+        }
+#else
+        for (size_t i = 0; i < BitmapWords; ++i) {
+            if constexpr (Op == BitOp::Or) {
+                a[i] |= b[i];
+            } else if constexpr (Op == BitOp::And) {
+                a[i] &= b[i];
+            } else {
+                a[i] &= ~b[i];
+            }
+            count += static_cast<uint32_t>(std::popcount(a[i]));
+        }
+#endif
+        return count;
+    }
+
+    uint32_t bitmap_and_count(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+    {
+        uint32_t count = 0;
+        for (size_t i = 0; i < BitmapWords; ++i) {
+            count += static_cast<uint32_t>(std::popcount(a[i] & b[i]));
+        }
+        return count;
+    }
+
+    // Returns the first index >= pos with data[index] >= target
+    size_t gallop(const std::vector<uint16_t>& data, size_t pos, uint16_t target)
+    {
+        if (pos >= data.size() || data[pos] >= target) {
+            return pos;
+        }
+        // data[pos] < target
+        size_t step = 1;
+        while (pos + step < data.size() && data[pos + step] < target) {
+            pos += step;
+            step *= 2;
+        }
+        const auto end = std::min(data.size(), pos + step + 1);
+        return static_cast<size_t>(
+            std::lower_bound(data.begin() + pos + 1, data.begin() + end, target) - data.begin());
+    }
+
+    // Calls out(uint16_t) for every value in both sorted arrays
+    template <typename Out>
+    void intersect_arrays(const std::vector<uint16_t>& a, const std::vector<uint16_t>& b, Out&& out)
+    {
+        // Galloping is only faster if the sizes are very different
+        constexpr size_t GallopRatio = 32;
+        if (a.size() * GallopRatio < b.size() || b.size() * GallopRatio < a.size()) {
+            const auto& small = a.size() < b.size() ? a : b;
+            const auto& large = a.size() < b.size() ? b : a;
+            size_t pos = 0;
+            for (const auto v : small) {
+                pos = gallop(large, pos, v);
+                if (pos == large.size()) {
+                    return;
+                }
+                if (large[pos] == v) {
+                    out(v);
+                }
+            }
+            return;
+        }
+
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (a[i] < b[j]) {
+                i++;
+            } else if (b[j] < a[i]) {
+                j++;
+            } else {
+                out(a[i]);
+                i++;
+                j++;
+            }
+        }
+    }
+
+    void to_bitmap(Container& c)
+    {
+        if (c.type == Type::Bitmap) {
+            return;
+        }
+        std::vector<uint64_t> words(BitmapWords, 0);
+        if (c.type == Type::Array) {
+            for (const auto v : c.values) {
+                bitmap_set(words, v);
+            }
+        } else {
+            for (size_t r = 0; r < c.values.size(); r += 2) {
+                bitmap_set_range(words, c.values[r], c.values[r] + c.values[r + 1] + 1u);
+            }
+        }
+        c.type = Type::Bitmap;
+        c.words = std::move(words);
+        c.values = std::vector<uint16_t>();
+    }
+
+    void to_array(Container& c)
+    {
+        if (c.type == Type::Array) {
+            return;
+        }
+        std::vector<uint16_t> values;
+        values.reserve(c.cardinality);
+        auto push = [&values](uint32_t v) { values.push_back(static_cast<uint16_t>(v)); };
+        detail::for_each_in_container(c, 0, push);
+        c.type = Type::Array;
+        c.values = std::move(values);
+        c.words = std::vector<uint64_t>();
+    }
+
+    // Brings a container into its canonical array or bitmap form
+    void normalize(Container& c)
+    {
+        if (c.cardinality <= MaxArraySize) {
+            to_array(c);
+        } else {
+            to_bitmap(c);
+        }
+    }
+
+    // Returns c itself or a normalized copy in tmp if c is a run container
+    const Container& materialize(const Container& c, Container& tmp)
+    {
+        if (c.type != Type::Run) {
+            return c;
+        }
+        tmp = c;
+        normalize(tmp);
+        return tmp;
+    }
+
+    bool container_contains(const Container& c, uint16_t v)
+    {
+        switch (c.type) {
+        case Type::Array:
+            return std::binary_search(c.values.begin(), c.values.end(), v);
+        case Type::Bitmap:
+            return bitmap_test(c.words, v);
+        case Type::Run: {
+            // Find the last run that starts at or before v
+            size_t lo = 0, hi = c.values.size() / 2;
+            while (lo < hi) {
+                const auto mid = (lo + hi) / 2;
+                if (c.values[mid * 2] <= v) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo > 0 && v - c.values[(lo - 1) * 2] <= c.values[(lo - 1) * 2 + 1];
+        }
+        }
+        return false;
+    }
+
+    bool container_add(Container& c, uint16_t v)
+    {
+        if (c.type == Type::Run) {
+            if (container_contains(c, v)) {
+                return false;
+            }
+            normalize(c);
+        }
+        if (c.type == Type::Array) {
+            const auto it = std::lower_bound(c.values.begin(), c.values.end(), v);
+            if (it != c.values.end() && *it == v) {
+                return false;
+            }
+            if (c.cardinality < MaxArraySize) {
+                c.values.insert(it, v);
+                c.cardinality++;
+                return true;
+            }
+            to_bitmap(c);
+        }
+        if (bitmap_test(c.words, v)) {
+            return false;
+        }
+        bitmap_set(c.words, v);
+        c.cardinality++;
+        return true;
+    }
+
+    bool container_remove(Container& c, uint16_t v)
+    {
+        if (!container_contains(c, v)) {
+            return false;
+        }
+        if (c.type == Type::Run) {
+            normalize(c);
+        }
+        if (c.type == Type::Array) {
+            c.values.erase(std::lower_bound(c.values.begin(), c.values.end(), v));
+        } else {
+            c.words[v >> 6] &= ~(uint64_t(1) << (v & 63));
+        }
+        c.cardinality--;
+        normalize(c);
+        return true;
+    }
+
+    void container_or(Container& a, const Container& b_in)
+    {
+        Container tmp;
+        const auto& b = materialize(b_in, tmp);
+        if (a.type == Type::Run) {
+            normalize(a);
+        }
+        if (a.type == Type::Array && b.type == Type::Array) {
+            std::vector<uint16_t> values;
+            values.reserve(a.values.size() + b.values.size());
+            std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                std::back_inserter(values));
+            a.values = std::move(values);
+            a.cardinality = static_cast<uint32_t>(a.values.size());
+            normalize(a);
+            return;
+        }
+        if (a.type == Type::Array) {
+            // The result is a bitmap, so start from b
+            auto words = b.words;
+            for (const auto v : a.values) {
+                bitmap_set(words, v);
+            }
+            a.type = Type::Bitmap;
+            a.words = std::move(words);
+            a.values = std::vector<uint16_t>();
+            a.cardinality = bitmap_count(a.words);
+        } else if (b.type == Type::Array) {
+            for (const auto v : b.values) {
+                bitmap_set(a.words, v);
+            }
+            a.cardinality = bitmap_count(a.words);
+        } else {
+            a.cardinality = bitmap_op<BitOp::Or>(a.words, b.words);
+        }
+    }
+
+    void container_and(Container& a, const Container& b_in)
+    {
+        Container tmp;
+        const auto& b = materialize(b_in, tmp);
+        if (a.type == Type::Run) {
+            normalize(a);
+        }
+        if (a.type == Type::Bitmap && b.type == Type::Bitmap) {
+            a.cardinality = bitmap_op<BitOp::And>(a.words, b.words);
+            normalize(a);
+            return;
+        }
+        std::vector<uint16_t> values;
+        if (a.type == Type::Array && b.type == Type::Array) {
+            values.reserve(std::min(a.values.size(), b.values.size()));
+            intersect_arrays(a.values, b.values, [&values](uint16_t v) { values.push_back(v); });
+        } else {
+            // One array and one bitmap, so the result is at most as big as the array
+            const auto& array = a.type == Type::Array ? a : b;
+            const auto& bitmap = a.type == Type::Array ? b : a;
+            values.reserve(array.values.size());
+            for (const auto v : array.values) {
+                if (bitmap_test(bitmap.words, v)) {
+                    values.push_back(v);
+                }
+            }
+        }
+        a.type = Type::Array;
+        a.values = std::move(values);
+        a.words = std::vector<uint64_t>();
+        a.cardinality = static_cast<uint32_t>(a.values.size());
+    }
+
+    void container_andnot(Container& a, const Container& b_in)
+    {
+        Container tmp;
+        const auto& b = materialize(b_in, tmp);
+        if (a.type == Type::Run) {
+            normalize(a);
+        }
+        if (a.type == Type::Array) {
+            std::vector<uint16_t> values;
+            values.reserve(a.values.size());
+            if (b.type == Type::Array) {
+                std::set_difference(a.values.begin(), a.values.end(), b.values.begin(),
+                    b.values.end(), std::back_inserter(values));
+            } else {
+                for (const auto v : a.values) {
+                    if (!bitmap_test(b.words, v)) {
+                        values.push_back(v);
+                    }
+                }
+            }
+            a.values = std::move(values);
+            a.cardinality = static_cast<uint32_t>(a.values.size());
+            return;
+        }
+        if (b.type == Type::Array) {
+            for (const auto v : b.values) {
+                a.words[v >> 6] &= ~(uint64_t(1) << (v & 63));
+            }
+            a.cardinality = bitmap_count(a.words);
+        } else {
+            a.cardinality = bitmap_op<BitOp::AndNot>(a.words, b.words);
+        }
+        normalize(a);
+    }
+
+    uint32_t container_and_count(const Container& a_in, const Container& b_in)
+    {
+        Container tmp_a, tmp_b;
+        const auto& a = materialize(a_in, tmp_a);
+        const auto& b = materialize(b_in, tmp_b);
+        if (a.type == Type::Bitmap && b.type == Type::Bitmap) {
+            return bitmap_and_count(a.words, b.words);
+        }
+        uint32_t count = 0;
+        if (a.type == Type::Array && b.type == Type::Array) {
+            intersect_arrays(a.values, b.values, [&count](uint16_t) { count++; });
+        } else {
+            const auto& array = a.type == Type::Array ? a : b;
+            const auto& bitmap = a.type == Type::Array ? b : a;
+            for (const auto v : array.values) {
+                count += bitmap_test(bitmap.words, v);
+            }
+        }
+        return count;
+    }
+
+    bool container_equal(const Container& a, const Container& b)
+    {
+        if (a.cardinality != b.cardinality) {
+            return false;
+        }
+        if (a.type == b.type) {
+            return a.values == b.values && a.words == b.words;
+        }
+        Container tmp_a = a, tmp_b = b;
+        to_bitmap(tmp_a);
+        to_bitmap(tmp_b);
+        return tmp_a.words == tmp_b.words;
+    }
+
+    size_t count_runs(const Container& c)
+    {
+        switch (c.type) {
+        case Type::Array: {
+            size_t runs = c.values.empty() ? 0 : 1;
+            for (size_t i = 1; i < c.values.size(); ++i) {
+                runs += c.values[i] != c.values[i - 1] + 1;
+            }
+            return runs;
+        }
+        case Type::Bitmap: {
+            // Count the bits that start a run, i.e. that are set and whose predecessor is not
+            size_t runs = 0;
+            uint64_t carry = 0;
+            for (const auto w : c.words) {
+                runs += static_cast<size_t>(std::popcount(w & ~((w << 1) | carry)));
+                carry = w >> 63;
+            }
+            return runs;
+        }
+        case Type::Run:
+            return c.values.size() / 2;
+        }
+        return 0;
+    }
+
+    void to_runs(Container& c)
+    {
+        if (c.type == Type::Run) {
+            return;
+        }
+        std::vector<uint16_t> runs;
+        runs.reserve(count_runs(c) * 2);
+        auto push = [&runs](uint32_t v) {
+            const auto n = runs.size();
+            if (n > 0 && runs[n - 2] + runs[n - 1] + 1u == v) {
+                runs[n - 1]++;
+            } else {
+                runs.push_back(static_cast<uint16_t>(v));
+                runs.push_back(0);
+            }
+        };
+        detail::for_each_in_container(c, 0, push);
+        c.type = Type::Run;
+        c.values = std::move(runs);
+        c.words = std::vector<uint64_t>();
+    }
+
+    Container make_run(uint32_t begin, uint32_t end)
+    {
+        assert(begin < end && end <= 65536);
+        Container c;
+        c.type = Type::Run;
+        c.cardinality = end - begin;
+        c.values = { static_cast<uint16_t>(begin), static_cast<uint16_t>(end - begin - 1) };
+        return c;
+    }
+
+    struct Writer {
+        std::vector<uint8_t>& out;
+
+        template <typename T>
+        void put(T v)
+        {
+            for (size_t i = 0; i < sizeof(T); ++i) {
+                out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+            }
+        }
+    };
+
+    struct Reader {
+        std::span<const uint8_t> data;
+        size_t pos = 0;
+
+        template <typename T>
+        bool get(T& v)
+        {
+            if (data.size() - pos < sizeof(T)) {
+                return false;
+            }
+            v = 0;
+            for (size_t i = 0; i < sizeof(T); ++i) {
+                v |= static_cast<T>(static_cast<T>(data[pos + i]) << (i * 8));
+            }
+            pos += sizeof(T);
+            return true;
+        }
+    };
+
+    constexpr uint32_t SerializationMagic = 0x31425250; // "PRB1"
+
+    std::optional<Container> read_container(Reader& reader)
+    {
+        uint8_t type;
+        uint32_t cardinality;
+        if (!reader.get(type) || !reader.get(cardinality) || type > 2 || cardinality == 0
+            || cardinality > 65536) {
+            return std::nullopt;
+        }
+        Container c;
+        c.type = static_cast<Type>(type);
+        c.cardinality = cardinality;
+        switch (c.type) {
+        case Type::Array:
+            if (cardinality > MaxArraySize) {
+                return std::nullopt;
+            }
+            c.values.resize(cardinality);
+            for (size_t i = 0; i < cardinality; ++i) {
+                if (!reader.get(c.values[i]) || (i > 0 && c.values[i] <= c.values[i - 1])) {
+                    return std::nullopt;
+                }
+            }
+            break;
+        case Type::Bitmap:
+            c.words.resize(BitmapWords);
+            for (auto& w : c.words) {
+                if (!reader.get(w)) {
+                    return std::nullopt;
+                }
+            }
+            if (bitmap_count(c.words) != cardinality) {
+                return std::nullopt;
+            }
+            normalize(c);
+            break;
+        case Type::Run: {
+            uint32_t num_runs;
+            if (!reader.get(num_runs) || num_runs == 0 || num_runs > 32768) {
+                return std::nullopt;
+            }
+            c.values.resize(num_runs * 2);
+            uint32_t total = 0;
+            uint32_t next_start = 0; // runs have to be sorted and not adjacent
+            for (size_t r = 0; r < num_runs; ++r) {
+                auto& start = c.values[r * 2];
+                auto& length = c.values[r * 2 + 1];
+                if (!reader.get(start) || !reader.get(length) || start < next_start
+                    || start + length > 65535u) {
+                    return std::nullopt;
+                }
+                next_start = start + length + 2u;
+                total += length + 1u;
+            }
+            if (total != cardinality) {
+                return std::nullopt;
+            }
+            break;
+        }
+        }
+        return c;
+    }
+}
+
+RoaringBitmap::RoaringBitmap(std::initializer_list<uint32_t> values)
+{
+    add_many(std::span<const uint32_t>(values.begin(), values.size()));
+}
+
+bool RoaringBitmap::add(uint32_t value)
+{
+    return container_add(get_or_insert_container(static_cast<uint16_t>(value >> 16)),
+        static_cast<uint16_t>(value));
+}
+
+void RoaringBitmap::add_many(std::span<const uint32_t> values)
+{
+    // Only look up the container if the key changes
+    Container* container = nullptr;
+    uint16_t key = 0;
+    for (const auto v : values) {
+        const auto high = static_cast<uint16_t>(v >> 16);
+        if (!container || high != key) {
+            container = &get_or_insert_container(high);
+            key = high;
+        }
+        container_add(*container, static_cast<uint16_t>(v));
+    }
+}
+
+void RoaringBitmap::add_range(uint64_t begin, uint64_t end)
+{
+    assert(begin <= end && end <= (uint64_t(1) << 32));
+    if (begin >= end) {
+        return;
+    }
+    const auto first_key = static_cast<uint32_t>(begin >> 16);
+    const auto last_key = static_cast<uint32_t>((end - 1) >> 16);
+    for (auto key = first_key; key <= last_key; ++key) {
+        const auto chunk_begin = key == first_key ? static_cast<uint32_t>(begin & 0xffff) : 0u;
+        const auto chunk_end
+            = key == last_key ? static_cast<uint32_t>((end - 1) & 0xffff) + 1 : 65536u;
+        const auto index = find_container(static_cast<uint16_t>(key));
+        if (index == containers_.size()) {
+            get_or_insert_container(static_cast<uint16_t>(key)) = make_run(chunk_begin, chunk_end);
+        } else if (chunk_begin == 0 && chunk_end == 65536) {
+            containers_[index] = make_run(chunk_begin, chunk_end);
+        } else {
+            auto& c = containers_[index];
+            to_bitmap(c);
+            bitmap_set_range(c.words, chunk_begin, chunk_end);
+            c.cardinality = bitmap_count(c.words);
+            normalize(c);
+        }
+    }
+}
+
+bool RoaringBitmap::remove(uint32_t value)
+{
+    const auto index = find_container(static_cast<uint16_t>(value >> 16));
+    if (index == containers_.size()
+        || !container_remove(containers_[index], static_cast<uint16_t>(value))) {
+        return false;
+    }
+    if (containers_[index].cardinality == 0) {
+        erase_container(index);
+    }
+    return true;
+}
+
+bool RoaringBitmap::contains(uint32_t value) const
+{
+    const auto index = find_container(static_cast<uint16_t>(value >> 16));
+    return index < containers_.size()
+        && container_contains(containers_[index], static_cast<uint16_t>(value));
+}
+
+uint64_t RoaringBitmap::size() const
+{
+    uint64_t size = 0;
+    for (const auto& c : containers_) {
+        size += c.cardinality;
+    }
+    return size;
+}
+
+void RoaringBitmap::clear()
+{
+    keys_.clear();
+    containers_.clear();
+}
+
+std::optional<uint32_t> RoaringBitmap::min() const
+{
+    if (empty()) {
+        return std::nullopt;
+    }
+    const auto high = static_cast<uint32_t>(keys_.front()) << 16;
+    const auto& c = containers_.front();
+    if (c.type == Type::Bitmap) {
+        for (uint32_t w = 0; w < BitmapWords; ++w) {
+            if (c.words[w]) {
+                return high | (w * 64 + static_cast<uint32_t>(std::countr_zero(c.words[w])));
+            }
+        }
+    }
+    // Arrays and runs start with the smallest value
+    return high | c.values.front();
+}
+
+std::optional<uint32_t> RoaringBitmap::max() const
+{
+    if (empty()) {
+        return std::nullopt;
+    }
+    const auto high = static_cast<uint32_t>(keys_.back()) << 16;
+    const auto& c = containers_.back();
+    switch (c.type) {
+    case Type::Array:
+        return high | c.values.back();
+    case Type::Bitmap:
+        for (auto w = BitmapWords; w-- > 0;) {
+            if (c.words[w]) {
+                return high | (w * 64 + 63 - static_cast<uint32_t>(std::countl_zero(c.words[w])));
+            }
+        }
+        break;
+    case Type::Run:
+        return high | (c.values[c.values.size() - 2] + c.values.back());
+    }
+    assert(false && "Empty container");
+    return std::nullopt;
+}
+
+RoaringBitmap& RoaringBitmap::operator|=(const RoaringBitmap& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    std::vector<uint16_t> keys;
+    std::vector<Container> containers;
+    keys.reserve(keys_.size() + other.keys_.size());
+    containers.reserve(keys_.size() + other.keys_.size());
+    size_t i = 0, j = 0;
+    while (i < keys_.size() || j < other.keys_.size()) {
+        if (j == other.keys_.size() || (i < keys_.size() && keys_[i] < other.keys_[j])) {
+            keys.push_back(keys_[i]);
+            containers.push_back(std::move(containers_[i++]));
+        } else if (i == keys_.size() || other.keys_[j] < keys_[i]) {
+            keys.push_back(other.keys_[j]);
+            containers.push_back(other.containers_[j++]);
+        } else {
+            container_or(containers_[i], other.containers_[j++]);
+            keys.push_back(keys_[i]);
+            containers.push_back(std::move(containers_[i++]));
+        }
+    }
+    keys_ = std::move(keys);
+    containers_ = std::move(containers);
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator&=(const RoaringBitmap& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    size_t num_kept = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        while (j < other.keys_.size() && other.keys_[j] < keys_[i]) {
+            j++;
+        }
+        if (j == other.keys_.size()) {
+            break;
+        }
+        if (other.keys_[j] != keys_[i]) {
+            continue;
+        }
+        container_and(containers_[i], other.containers_[j]);
+        if (containers_[i].cardinality > 0) {
+            if (num_kept != i) {
+                keys_[num_kept] = keys_[i];
+                containers_[num_kept] = std::move(containers_[i]);
+            }
+            num_kept++;
+        }
+    }
+    keys_.resize(num_kept);
+    containers_.resize(num_kept);
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator-=(const RoaringBitmap& other)
+{
+    if (this == &other) {
+        clear();
+        return *this;
+    }
+    size_t num_kept = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        while (j < other.keys_.size() && other.keys_[j] < keys_[i]) {
+            j++;
+        }
+        if (j < other.keys_.size() && other.keys_[j] == keys_[i]) {
+            container_andnot(containers_[i], other.containers_[j]);
+        }
+        if (containers_[i].cardinality > 0) {
+            if (num_kept != i) {
+                keys_[num_kept] = keys_[i];
+                containers_[num_kept] = std::move(containers_[i]);
+            }
+            num_kept++;
+        }
+    }
+    keys_.resize(num_kept);
+    containers_.resize(num_kept);
+    return *this;
+}
+
+bool RoaringBitmap::intersects(const RoaringBitmap& other) const
+{
+    size_t i = 0, j = 0;
+    while (i < keys_.size() && j < other.keys_.size()) {
+        if (keys_[i] < other.keys_[j]) {
+            i++;
+        } else if (other.keys_[j] < keys_[i]) {
+            j++;
+        } else if (container_and_count(containers_[i++], other.containers_[j++]) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t RoaringBitmap::intersection_size(const RoaringBitmap& other) const
+{
+    uint64_t size = 0;
+    size_t i = 0, j = 0;
+    while (i < keys_.size() && j < other.keys_.size()) {
+        if (keys_[i] < other.keys_[j]) {
+            i++;
+        } else if (other.keys_[j] < keys_[i]) {
+            j++;
+        } else {
+            size += container_and_count(containers_[i++], other.containers_[j++]);
+        }
+    }
+    return size;
+}
+
+bool RoaringBitmap::operator==(const RoaringBitmap& other) const
+{
+    if (keys_ != other.keys_) {
+        return false;
+    }
+    for (size_t i = 0; i < containers_.size(); ++i) {
+        if (!container_equal(containers_[i], other.containers_[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RoaringBitmap::run_optimize()
+{
+    bool has_runs = false;
+    for (auto& c : containers_) {
+        // Sizes in bytes
+        const auto run_size = 4 * count_runs(c);
+        const auto array_size = c.cardinality <= MaxArraySize ? 2 * c.cardinality : SIZE_MAX;
+        const auto bitmap_size = BitmapWords * 8;
+        if (run_size < std::min<size_t>(array_size, bitmap_size)) {
+            to_runs(c);
+            has_runs = true;
+        } else {
+            normalize(c);
+        }
+    }
+    return has_runs;
+}
+
+size_t RoaringBitmap::memory_usage() const
+{
+    size_t size = keys_.capacity() * sizeof(uint16_t) + containers_.capacity() * sizeof(Container);
+    for (const auto& c : containers_) {
+        size += c.values.capacity() * sizeof(uint16_t) + c.words.capacity() * sizeof(uint64_t);
+    }
+    return size;
+}
+
+std::vector<uint32_t> RoaringBitmap::to_vector() const
+{
+    std::vector<uint32_t> values;
+    values.reserve(size());
+    for_each([&values](uint32_t v) { values.push_back(v); });
+    return values;
+}
+
+// Format (all little endian):
+// u32 magic, u32 number of containers, then for every container:
+// u16 key, u8 type, u32 cardinality and depending on the type:
+// - Array: cardinality x u16 value
+// - Bitmap: 1024 x u64 word
+// - Run: u32 number of runs, then number of runs x (u16 start, u16 length - 1)
+std::vector<uint8_t> RoaringBitmap::serialize() const
+{
+    std::vector<uint8_t> data;
+    Writer writer { data };
+    writer.put(SerializationMagic);
+    writer.put(static_cast<uint32_t>(keys_.size()));
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        const auto& c = containers_[i];
+        writer.put(keys_[i]);
+        writer.put(static_cast<uint8_t>(c.type));
+        writer.put(c.cardinality);
+        if (c.type == Type::Run) {
+            writer.put(static_cast<uint32_t>(c.values.size() / 2));
+        }
+        for (const auto v : c.values) {
+            writer.put(v);
+        }
+        for (const auto w : c.words) {
+            writer.put(w);
+        }
+    }
+    return data;
+}
+
+std::optional<RoaringBitmap> RoaringBitmap::deserialize(std::span<const uint8_t> data)
+{
+    Reader reader { data };
+    uint32_t magic, num_containers;
+    if (!reader.get(magic) || magic != SerializationMagic || !reader.get(num_containers)) {
+        return std::nullopt;
+    }
+    RoaringBitmap bitmap;
+    for (uint32_t i = 0; i < num_containers; ++i) {
+        uint16_t key;
+        if (!reader.get(key) || (!bitmap.keys_.empty() && key <= bitmap.keys_.back())) {
+            return std::nullopt;
+        }
+        auto container = read_container(reader);
+        if (!container) {
+            return std::nullopt;
+        }
+        bitmap.keys_.push_back(key);
+        bitmap.containers_.push_back(std::move(*container));
+    }
+    if (reader.pos != data.size()) {
+        return std::nullopt;
+    }
+    return bitmap;
+}
+
+size_t RoaringBitmap::find_container(uint16_t key) const
+{
+    const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+    return it != keys_.end() && *it == key ? static_cast<size_t>(it - keys_.begin())
+                                           : containers_.size();
+}
+
+RoaringBitmap::Container& RoaringBitmap::get_or_insert_container(uint16_t key)
+{
+    const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+    const auto index = static_cast<size_t>(it - keys_.begin());
+    if (it == keys_.end() || *it != key) {
+        keys_.insert(it, key);
+        containers_.insert(containers_.begin() + static_cast<ptrdiff_t>(index), Container());
+    }
+    return containers_[index];
+}
+
+void RoaringBitmap::erase_container(size_t index)
+{
+    keys_.erase(keys_.begin() + static_cast<ptrdiff_t>(index));
+    containers_.erase(containers_.begin() + static_cast<ptrdiff_t>(index));
+}
+
+}
@@ -75,6 +75,21 @@ std::vector<std::string> split(std::string_view str)
     return parts;
 }
 
+std::vector<std::string> split(std::string_view str, char delim)
+{
+    std::vector<std::string> parts;
+    size_t pos = 0;
+    while (true) {
+        const auto end = str.find(delim, pos);
+        if (end == std::string_view::npos) {
+            parts.emplace_back(str.substr(pos));
+            return parts;
+        }
+        parts.emplace_back(str.substr(pos, end - pos));
+        pos = end + 1;
+    }
+}
+
 bool startsWith(std::string_view str, std::string_view with)
 {
     return str.substr(0, with.size()) == with;
@@ -82,7 +97,7 @@ bool startsWith(std::string_view str, std::string_view with)
 
 bool endsWith(std::string_view str, std::string_view with)
 {
-    return str.substr(str.size() - with.size()) == with;
+    return str.size() >= with.size() && str.substr(str.size() - with.size()) == with;
 }
 
 }
@@ -0,0 +1,126 @@
+#include "cppasta/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace pasta {
+
+namespace {
+    // Set on the worker threads and on a thread that is currently inside run()
+    thread_local bool inside_pool = false;
+}
+
+ThreadPool::ThreadPool(size_t num_workers)
+{
+    workers_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers_.emplace_back([this] { worker(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto& thread : workers_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(size_t num_chunks, const std::function<void(size_t)>& func)
+{
+    if (num_chunks == 0) {
+        return;
+    }
+    if (num_chunks == 1 || workers_.empty() || inside_pool) {
+        for (size_t i = 0; i < num_chunks; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::lock_guard run_lock(run_mutex_);
+    Job job;
+    job.func = &func;
+    job.num_chunks = num_chunks;
+    {
+        std::lock_guard lock(mutex_);
+        job_ = &job;
+        generation_++;
+    }
+    job_cv_.notify_all();
+
+    inside_pool = true;
+    execute(job);
+    inside_pool = false;
+
+    // All chunks have been claimed, but workers might still be executing theirs
+    {
+        std::unique_lock lock(mutex_);
+        job_ = nullptr;
+        done_cv_.wait(lock, [this] { return num_active_ == 0; });
+    }
+    if (job.exception) {
+        std::rethrow_exception(job.exception);
+    }
+}
+
+size_t ThreadPool::default_num_workers()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+}
+
+void ThreadPool::worker()
+{
+    inside_pool = true;
+    uint64_t seen_generation = 0;
+    std::unique_lock lock(mutex_);
+    while (true) {
+        job_cv_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+        if (stop_) {
+            return;
+        }
+        seen_generation = generation_;
+        // The job might already be finished if this thread woke up late
+        if (!job_) {
+            continue;
+        }
+        auto job = job_;
+        num_active_++;
+        lock.unlock();
+        execute(*job);
+        lock.lock();
+        num_active_--;
+        if (num_active_ == 0) {
+            done_cv_.notify_all();
+        }
+    }
+}
+
+void ThreadPool::execute(Job& job)
+{
+    while (true) {
+        const auto chunk = job.next_chunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= job.num_chunks) {
+            return;
+        }
+        try {
+            (*job.func)(chunk);
+        } catch (...) {
+            std::lock_guard lock(job.exception_mutex);
+            if (!job.exception) {
+                job.exception = std::current_exception();
+            }
+        }
+    }
+}
+
+ThreadPool& getThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+}
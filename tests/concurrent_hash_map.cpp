@@ -0,0 +1,170 @@
+#include <atomic>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/concurrent_hash_map.hpp>
+
+using namespace pasta;
+
+TEST_CASE("ConcurrentHashMap single threaded", "[concurrent_hash_map]")
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> key_dist(0, 5000);
+    std::uniform_int_distribution<int> op_dist(0, 3);
+
+    ConcurrentHashMap<uint32_t, uint64_t> map(4);
+    std::unordered_map<uint32_t, uint64_t> ref;
+    for (uint64_t i = 0; i < 50'000; ++i) {
+        const auto key = key_dist(rng);
+        switch (op_dist(rng)) {
+        case 0:
+            REQUIRE(map.insert(key, i) == ref.emplace(key, i).second);
+            break;
+        case 1:
+            REQUIRE(map.insert_or_assign(key, i) == !ref.contains(key));
+            ref[key] = i;
+            break;
+        case 2:
+            REQUIRE(map.erase(key) == (ref.erase(key) > 0));
+            break;
+        case 3: {
+            const auto v = map.find(key);
+            const auto it = ref.find(key);
+            REQUIRE(v.has_value() == (it != ref.end()));
+            if (v) {
+                REQUIRE(*v == it->second);
+            }
+            break;
+        }
+        }
+        REQUIRE(map.size() == ref.size());
+    }
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(!map.contains(key_dist(rng)));
+}
+
+TEST_CASE("ConcurrentHashMap clear and reclaim", "[concurrent_hash_map]")
+{
+    ConcurrentHashMap<uint32_t, uint32_t> map(4);
+    for (uint32_t i = 0; i < 10'000; ++i) {
+        map.insert(i, i);
+    }
+    const auto capacity = map.capacity();
+    REQUIRE(map.retired_capacity() > 0);
+    REQUIRE(map.retired_capacity() <= capacity);
+
+    // Clearing keeps the tables, so refilling doesn't grow or retire anything
+    const auto retired = map.retired_capacity();
+    for (uint32_t round = 0; round < 20; ++round) {
+        map.clear();
+        REQUIRE(map.empty());
+        REQUIRE(!map.contains(round));
+        for (uint32_t i = 0; i < 10'000; ++i) {
+            REQUIRE(map.insert(i, i + round));
+        }
+        REQUIRE(map.size() == 10'000);
+        REQUIRE(map.find(round) == round * 2);
+    }
+    REQUIRE(map.capacity() == capacity);
+    REQUIRE(map.retired_capacity() == retired);
+
+    map.reclaim();
+    REQUIRE(map.retired_capacity() == 0);
+    REQUIRE(map.size() == 10'000);
+    REQUIRE(map.find(42) == 42 + 19);
+}
+
+TEST_CASE("ConcurrentHashMap batched", "[concurrent_hash_map]")
+{
+    ConcurrentHashMap<uint32_t, uint32_t> map(8);
+    std::vector<std::pair<uint32_t, uint32_t>> values;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        values.emplace_back(i, i * 2);
+    }
+    REQUIRE(map.insert_many(values) == 1000);
+    REQUIRE(map.insert_many(values) == 0);
+    REQUIRE(map.size() == 1000);
+
+    std::vector<uint32_t> keys;
+    for (uint32_t i = 0; i < 2000; i += 2) {
+        keys.push_back(i);
+    }
+    std::vector<std::optional<uint32_t>> out(keys.size());
+    map.find_many(keys, out);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] < 1000) {
+            REQUIRE(out[i] == keys[i] * 2);
+        } else {
+            REQUIRE(!out[i]);
+        }
+    }
+}
+
+TEST_CASE("ConcurrentHashMap concurrent", "[concurrent_hash_map]")
+{
+    // Values are always key * 3 + n for the same n in both halves, so a torn read is detectable
+    struct Value {
+        uint64_t a;
+        uint64_t b;
+    };
+    ConcurrentHashMap<uint32_t, Value> map(4);
+    constexpr uint32_t num_keys = 4096;
+    std::atomic<bool> stop { false };
+
+    std::vector<std::thread> writers;
+    for (uint32_t t = 0; t < 2; ++t) {
+        writers.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            for (uint64_t i = 0; i < 100'000; ++i) {
+                const auto key = static_cast<uint32_t>(rng() % num_keys);
+                if (t == 0 && i % 20'000 == 0) {
+                    map.clear();
+                } else if (i % 3 == 0) {
+                    map.erase(key);
+                } else {
+                    map.insert_or_assign(key, Value { key * 3 + i, key * 3 + i });
+                }
+            }
+        });
+    }
+
+    std::atomic<size_t> torn { 0 };
+    std::atomic<size_t> found { 0 };
+    std::vector<std::thread> readers;
+    for (uint32_t t = 0; t < 2; ++t) {
+        readers.emplace_back([&, t] {
+            std::mt19937 rng(t + 100);
+            while (!stop.load()) {
+                const auto key = static_cast<uint32_t>(rng() % num_keys);
+                if (const auto v = map.find(key)) {
+                    found++;
+                    if (v->a != v->b || v->a < key * 3) {
+                        torn++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& w : writers) {
+        w.join();
+    }
+    stop.store(true);
+    for (auto& r : readers) {
+        r.join();
+    }
+    REQUIRE(torn.load() == 0);
+
+    size_t count = 0;
+    for (uint32_t key = 0; key < num_keys; ++key) {
+        count += map.contains(key) ? 1 : 0;
+    }
+    REQUIRE(count == map.size());
+}
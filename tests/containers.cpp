@@ -0,0 +1,72 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/containers.hpp>
+
+using namespace pasta;
+
+template <typename T>
+void test_search()
+{
+    // Long enough for a few vector registers and a scalar tail
+    std::vector<T> values;
+    for (int i = 0; i < 77; ++i) {
+        values.push_back(static_cast<T>(i % 50));
+    }
+    for (int i = 0; i < 50; ++i) {
+        REQUIRE(indexOf(values, static_cast<T>(i)) == i);
+        REQUIRE(contains(values, static_cast<T>(i)));
+        REQUIRE(count(values, static_cast<T>(i)) == (i < 27 ? 2 : 1));
+    }
+    REQUIRE(!indexOf(values, static_cast<T>(100)));
+    REQUIRE(count(values, static_cast<T>(100)) == 0);
+    REQUIRE(!contains(std::vector<T> {}, static_cast<T>(0)));
+}
+
+TEST_CASE("indexOf/count for arithmetic types", "[containers]")
+{
+    test_search<int8_t>();
+    test_search<uint16_t>();
+    test_search<int32_t>();
+    test_search<uint64_t>();
+    test_search<float>();
+    test_search<double>();
+}
+
+TEST_CASE("indexOf/count edge cases", "[containers]")
+{
+    enum class Id : uint32_t { A, B, C };
+    const std::array ids { Id::C, Id::A, Id::B, Id::A };
+    REQUIRE(indexOf(ids, Id::A) == 1);
+    REQUIRE(count(ids, Id::A) == 2);
+
+    // Same results as operator==
+    const std::vector<uint32_t> u { 1, 2, 0xffffffff };
+    REQUIRE(indexOf(u, -1) == 2);
+    const std::vector<uint8_t> bytes(40, 255);
+    REQUIRE(!contains(bytes, -1));
+    REQUIRE(count(bytes, 255) == 40);
+    REQUIRE(!contains(bytes, 255 + 256));
+
+    std::vector<float> floats(20, 1.0f);
+    floats[17] = -0.0f;
+    floats[18] = NAN;
+    REQUIRE(indexOf(floats, 0.0f) == 17);
+    REQUIRE(!contains(floats, NAN));
+    REQUIRE(indexOf(floats, 1) == 0);
+    REQUIRE(!contains(floats, 1.1));
+
+    // Non-contiguous and non-arithmetic containers use std::find
+    const std::list<int> list { 3, 4, 5 };
+    REQUIRE(indexOf(list, 5) == 2);
+    const std::vector<std::string> strings { "a", "b", "b" };
+    REQUIRE(indexOf(strings, "b") == 1);
+    REQUIRE(count(strings, "b") == 2);
+}
@@ -0,0 +1,118 @@
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/dynamic_bitset.hpp>
+
+using namespace pasta;
+
+static std::vector<size_t> set_bits(const DynamicBitset& bs)
+{
+    std::vector<size_t> r;
+    for (const auto idx : bs.set_bits()) {
+        r.push_back(idx);
+    }
+    return r;
+}
+
+TEST_CASE("DynamicBitset basic", "[dynamic_bitset]")
+{
+    using V = std::vector<size_t>;
+    DynamicBitset bs(130);
+    REQUIRE(bs.size() == 130);
+    REQUIRE(bs.none());
+    REQUIRE(bs.find_first_set() == DynamicBitset::npos);
+    REQUIRE(bs.find_first_unset() == 0);
+
+    bs.set(0);
+    bs.set(64);
+    bs.set(129);
+    bs.set(70, true);
+    bs.set(70, false);
+    REQUIRE(bs.count() == 3);
+    REQUIRE(bs.test(64));
+    REQUIRE(!bs[65]);
+    REQUIRE(set_bits(bs) == V { 0, 64, 129 });
+    REQUIRE(bs.find_next_set(1) == 64);
+    REQUIRE(bs.find_next_set(65) == 129);
+    REQUIRE(bs.find_next_set(130) == DynamicBitset::npos);
+
+    bs.flip(0);
+    bs.reset(129);
+    REQUIRE(set_bits(bs) == V { 64 });
+
+    bs.set_range(60, 75);
+    REQUIRE(bs.count() == 15);
+    REQUIRE(bs.find_next_unset(60) == 75);
+    bs.reset_range(62, 63);
+    REQUIRE(bs.find_next_unset(60) == 62);
+
+    // The padding stays zero
+    bs.set();
+    REQUIRE(bs.all());
+    REQUIRE(bs.count() == 130);
+    REQUIRE(bs.find_first_unset() == DynamicBitset::npos);
+    bs.flip();
+    REQUIRE(bs.none());
+
+    bs.resize(200, true);
+    REQUIRE(bs.count() == 70);
+    REQUIRE(bs.find_first_set() == 130);
+    bs.resize(140);
+    REQUIRE(bs.count() == 10);
+    bs.resize(300);
+    REQUIRE(bs.count() == 10);
+    REQUIRE(bs.find_next_set(140) == DynamicBitset::npos);
+}
+
+TEST_CASE("DynamicBitset against std::vector<bool>", "[dynamic_bitset]")
+{
+    std::mt19937 rng(1);
+    // Sizes around the SIMD block sizes
+    for (const size_t size : { 1, 63, 64, 65, 255, 256, 257, 1000, 10000 }) {
+        std::vector<bool> ra(size), rb(size);
+        DynamicBitset a(size), b(size);
+        // Mostly sparse or mostly dense, so the scans have to skip whole words
+        const auto density = size % 2 ? 0.02 : 0.98;
+        std::bernoulli_distribution dist(density);
+        for (size_t i = 0; i < size; ++i) {
+            ra[i] = dist(rng);
+            rb[i] = dist(rng);
+            a.set(i, ra[i]);
+            b.set(i, rb[i]);
+        }
+
+        size_t count = 0;
+        for (size_t i = 0; i < size; ++i) {
+            count += ra[i];
+        }
+        REQUIRE(a.count() == count);
+
+        for (size_t pos = 0; pos < size; ++pos) {
+            size_t next = pos, next_unset = pos;
+            while (next < size && !ra[next]) {
+                next++;
+            }
+            while (next_unset < size && ra[next_unset]) {
+                next_unset++;
+            }
+            REQUIRE(a.find_next_set(pos) == (next < size ? next : DynamicBitset::npos));
+            REQUIRE(a.find_next_unset(pos)
+                == (next_unset < size ? next_unset : DynamicBitset::npos));
+        }
+
+        const auto check = [&](const DynamicBitset& result, auto op) {
+            for (size_t i = 0; i < size; ++i) {
+                REQUIRE(result.test(i) == op(ra[i], rb[i]));
+            }
+        };
+        check(a & b, [](bool x, bool y) { return x && y; });
+        check(a | b, [](bool x, bool y) { return x || y; });
+        check(a ^ b, [](bool x, bool y) { return x != y; });
+        check(a - b, [](bool x, bool y) { return x && !y; });
+        REQUIRE((a ^ a).none());
+        REQUIRE((a | b) == (b | a));
+    }
+}
@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/dense_slot_map.hpp>
+#include <cppasta/filter.hpp>
+
+using namespace pasta;
+
+template <typename T, typename Pred>
+std::vector<T> reference_filter(const std::vector<T>& in, Pred pred)
+{
+    std::vector<T> out;
+    for (const auto& v : in) {
+        if (pred(v)) {
+            out.push_back(v);
+        }
+    }
+    return out;
+}
+
+template <typename T>
+void test_compact()
+{
+    const auto pred = [](T v) { return static_cast<int64_t>(v) % 3 != 0; };
+    // Sizes around multiples of the vector width, so the scalar tail is tested too
+    for (const size_t n : { 0, 1, 7, 8, 9, 16, 17, 100, 1000 }) {
+        std::vector<T> in;
+        for (size_t i = 0; i < n; ++i) {
+            in.push_back(static_cast<T>((i * 7919) % 1000));
+        }
+        const auto expected = reference_filter(in, pred);
+
+        std::vector<T> out(n);
+        out.resize(compact_if(in, pred, out));
+        REQUIRE(out == expected);
+
+        // In-place
+        out = in;
+        out.resize(compact_if(out, pred, out));
+        REQUIRE(out == expected);
+
+        const auto indices = select_indices(in, pred);
+        REQUIRE(indices.size() == expected.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            REQUIRE(in[indices[i]] == expected[i]);
+        }
+    }
+}
+
+TEST_CASE("compact_if", "[filter]")
+{
+    test_compact<uint32_t>();
+    test_compact<int64_t>();
+    test_compact<float>();
+    test_compact<double>();
+    test_compact<uint16_t>();
+
+    const auto pred = [](const std::string& s) { return s.size() > 1; };
+    const std::vector<std::string> in { "a", "bb", "", "ccc", "d", "ee" };
+    std::vector<std::string> out(in.size());
+    out.resize(compact_if(in, pred, out));
+    REQUIRE(out == std::vector<std::string> { "bb", "ccc", "ee" });
+
+    REQUIRE(select_indices(in, pred) == std::vector<uint32_t> { 1, 3, 5 });
+}
+
+struct Agent {
+    float x;
+    bool visible;
+};
+
+TEST_CASE("select_keys", "[filter]")
+{
+    DenseSlotMap<Agent, std::vector, std::vector> agents(1000);
+    std::vector<decltype(agents)::Key> keys;
+    for (size_t i = 0; i < 100; ++i) {
+        keys.push_back(agents.insert(Agent { static_cast<float>(i), i % 4 == 0 }));
+    }
+    // Removing moves elements around, so the data order differs from the key order
+    for (size_t i = 0; i < 100; i += 5) {
+        agents.remove(keys[i]);
+    }
+
+    const auto visible = select_keys(agents, [](const Agent& a) { return a.visible; });
+    size_t expected = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        expected += i % 4 == 0 && i % 5 != 0;
+    }
+    REQUIRE(visible.size() == expected);
+    for (const auto& key : visible) {
+        REQUIRE(agents.contains(key));
+        const auto x = static_cast<size_t>(agents.get(key)->x);
+        REQUIRE(x % 4 == 0);
+        REQUIRE(keys[x] == key);
+    }
+}
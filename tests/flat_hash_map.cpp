@@ -0,0 +1,218 @@
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/flat_hash_map.hpp>
+
+using namespace pasta;
+
+template <typename Map>
+auto sorted(const Map& map)
+{
+    return std::map<typename Map::key_type, typename Map::mapped_type>(map.begin(), map.end());
+}
+
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const { return std::hash<std::string_view> {}(str); }
+};
+
+struct StringEqual {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+};
+
+TEST_CASE("flat_hash_map basics", "[flat_hash_map]")
+{
+    using M = std::map<std::string, int>;
+
+    flat_hash_map<std::string, int> map;
+    REQUIRE(map.empty());
+    REQUIRE(map.find("foo") == map.end());
+
+    REQUIRE(map.insert("foo", 1).second);
+    REQUIRE(map.insert({ "bar", 2 }).second);
+    REQUIRE(!map.insert("foo", 3).second);
+    REQUIRE(map.try_emplace("baz", 3).second);
+    map["zap"] = 4;
+    REQUIRE(map.size() == 4);
+    REQUIRE(sorted(map) == M { { "foo", 1 }, { "bar", 2 }, { "baz", 3 }, { "zap", 4 } });
+
+    REQUIRE(map.at("foo") == 1);
+    REQUIRE_THROWS_AS(map.at("nope"), std::out_of_range);
+    REQUIRE(map.contains("bar"));
+    REQUIRE(map.count("nope") == 0);
+
+    map.insert_or_assign("foo", 5);
+    REQUIRE(map.find("foo")->second == 5);
+
+    REQUIRE(map.erase("bar") == 1);
+    REQUIRE(map.erase("bar") == 0);
+    REQUIRE(sorted(map) == M { { "foo", 5 }, { "baz", 3 }, { "zap", 4 } });
+
+    const auto copy = map;
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.find("foo") == map.end());
+    REQUIRE(sorted(copy) == M { { "foo", 5 }, { "baz", 3 }, { "zap", 4 } });
+}
+
+// Returns byte arrays that are never 16-byte aligned (allowed for types with alignment 1)
+template <typename T>
+struct MisalignedAllocator {
+    using value_type = T;
+
+    MisalignedAllocator() = default;
+
+    template <typename U>
+    MisalignedAllocator(const MisalignedAllocator<U>&)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if constexpr (alignof(T) == 1) {
+            auto p = std::allocator<T>().allocate(n + 16);
+            return p + 1;
+        } else {
+            return std::allocator<T>().allocate(n);
+        }
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if constexpr (alignof(T) == 1) {
+            std::allocator<T>().deallocate(p - 1, n + 16);
+        } else {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    bool operator==(const MisalignedAllocator&) const = default;
+};
+
+TEST_CASE("flat_hash_map with misaligned control bytes", "[flat_hash_map]")
+{
+    flat_hash_map<int, int, std::hash<int>, std::equal_to<int>,
+        MisalignedAllocator<std::pair<const int, int>>>
+        map;
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(map.insert(i, i * 2).second);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        REQUIRE(map.erase(i) == 1);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        const auto it = map.find(i);
+        REQUIRE((it != map.end()) == (i % 2 == 1));
+    }
+    REQUIRE(map.size() == 500);
+}
+
+TEST_CASE("flat_hash_map heterogeneous lookup", "[flat_hash_map]")
+{
+    flat_hash_map<std::string, int, StringHash, StringEqual> map;
+    map["foo"] = 1;
+    const std::string_view key = "foo";
+    REQUIRE(map.find(key) != map.end());
+    REQUIRE(map.contains(key));
+    REQUIRE(map.at(key) == 1);
+    REQUIRE(map.erase(key) == 1);
+    REQUIRE(map.empty());
+}
+
+TEST_CASE("flat_hash_map against unordered_map", "[flat_hash_map]")
+{
+    // Small key range, so we get many collisions, erasures and reinsertions (and tombstones)
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> key_dist(0, 2000);
+    std::uniform_int_distribution<int> op_dist(0, 2);
+
+    flat_hash_map<uint32_t, uint32_t> map;
+    std::unordered_map<uint32_t, uint32_t> ref;
+    for (size_t i = 0; i < 100'000; ++i) {
+        const auto key = key_dist(rng);
+        switch (op_dist(rng)) {
+        case 0:
+            REQUIRE(map.insert(key, static_cast<uint32_t>(i)).second
+                == ref.emplace(key, static_cast<uint32_t>(i)).second);
+            break;
+        case 1:
+            REQUIRE(map.erase(key) == ref.erase(key));
+            break;
+        case 2: {
+            const auto it = map.find(key);
+            const auto ref_it = ref.find(key);
+            REQUIRE((it == map.end()) == (ref_it == ref.end()));
+            if (it != map.end()) {
+                REQUIRE(it->second == ref_it->second);
+            }
+            break;
+        }
+        }
+        REQUIRE(map.size() == ref.size());
+    }
+    REQUIRE(sorted(map) == std::map<uint32_t, uint32_t>(ref.begin(), ref.end()));
+    // 7/8 max load factor
+    REQUIRE(map.load_factor() <= 0.875f);
+}
+
+TEST_CASE("flat_hash_map erase during iteration", "[flat_hash_map]")
+{
+    flat_hash_map<int, int> map;
+    map.reserve(1000);
+    const auto capacity = map.capacity();
+    for (int i = 0; i < 1000; ++i) {
+        map[i] = i;
+    }
+    REQUIRE(map.capacity() == capacity);
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->first % 2 == 0) {
+            it = map.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    REQUIRE(map.size() == 500);
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(map.contains(i) == (i % 2 == 1));
+    }
+}
+
+TEST_CASE("flat_hash_set", "[flat_hash_map]")
+{
+    flat_hash_set<int> set;
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(set.insert(i).second);
+    }
+    REQUIRE(!set.insert(42).second);
+    REQUIRE(set.size() == 100);
+    REQUIRE(set.erase(42) == 1);
+    REQUIRE(!set.contains(42));
+    REQUIRE(*set.find(43) == 43);
+
+    std::vector<int> values(set.begin(), set.end());
+    std::sort(values.begin(), values.end());
+    REQUIRE(values.size() == 99);
+    REQUIRE(values.front() == 0);
+    REQUIRE(values.back() == 99);
+
+    // Keys must not be modifiable through the iterator erase returns
+    static_assert(std::is_same_v<decltype(set.erase(set.begin())),
+        flat_hash_set<int>::const_iterator>);
+    const auto it = set.erase(set.find(43));
+    REQUIRE(!set.contains(43));
+    REQUIRE((it == set.end() || set.contains(*it)));
+
+    flat_hash_set<int> empty;
+    const auto copy = empty;
+    REQUIRE(copy.capacity() == 0);
+    REQUIRE(copy.empty());
+}
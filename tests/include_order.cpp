@@ -0,0 +1,23 @@
+// parallel.hpp has its own detail namespace, so it has to be included before radix_sort.hpp here,
+// to catch unqualified uses of detail inside pasta::parallel.
+#include <cppasta/parallel.hpp>
+#include <cppasta/radix_sort.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+using namespace pasta;
+
+TEST_CASE("parallel::radix_sort after parallel.hpp", "[include_order]")
+{
+    std::vector<uint32_t> keys { 5, 3, 9, 1, 7 };
+    std::vector<uint32_t> values { 0, 1, 2, 3, 4 };
+    ThreadPool pool(2);
+    parallel::radix_sort(keys, values, pool, 2);
+    REQUIRE(keys == std::vector<uint32_t> { 1, 3, 5, 7, 9 });
+    REQUIRE(values == std::vector<uint32_t> { 3, 1, 0, 4, 2 });
+}
@@ -0,0 +1,90 @@
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include <cppasta/incremental_vector.hpp>
+
+using namespace pasta;
+
+template <typename T>
+std::vector<T> collect(const IncrementalVector<T>& v)
+{
+    return std::vector<T>(v.begin(), v.end());
+}
+
+static std::string value(size_t i)
+{
+    return std::to_string(i) + " is long enough to not be stored inline";
+}
+
+TEST_CASE("IncrementalVector", "[incremental_vector]")
+{
+    IncrementalVector<std::string> vec;
+    REQUIRE(vec.empty());
+    REQUIRE(vec.capacity() == 0);
+
+    std::vector<std::string> ref;
+    for (size_t i = 0; i < 1000; ++i) {
+        vec.push_back(value(i));
+        ref.push_back(value(i));
+        REQUIRE(vec.size() == ref.size());
+        REQUIRE(vec.back() == ref.back());
+        REQUIRE(vec[0] == ref[0]);
+    }
+    REQUIRE(vec.capacity() == 1024);
+    // 1000 - 512 pushes since the last growth are enough to migrate 512 elements
+    REQUIRE(!vec.migrating());
+    REQUIRE(collect(vec) == ref);
+
+    for (size_t i = 0; i < 600; ++i) {
+        vec.pop_back();
+        ref.pop_back();
+    }
+    REQUIRE(collect(vec) == ref);
+
+    vec.reserve(2048);
+    REQUIRE(vec.capacity() == 2048);
+    REQUIRE(vec.migrating());
+    REQUIRE(collect(vec) == ref);
+    vec.finish_migration();
+    REQUIRE(!vec.migrating());
+    REQUIRE(collect(vec) == ref);
+}
+
+TEST_CASE("IncrementalVector migration", "[incremental_vector]")
+{
+    IncrementalVector<std::string> vec;
+    std::vector<std::string> ref;
+    for (size_t i = 0; i < 512; ++i) {
+        vec.push_back(value(i));
+        ref.push_back(value(i));
+    }
+    vec.finish_migration();
+
+    // Grows, but only moves MigrationStep elements
+    vec.emplace_back(vec[3]);
+    ref.push_back(ref[3]);
+    REQUIRE(vec.capacity() == 1024);
+    REQUIRE(vec.migrating());
+    REQUIRE(collect(vec) == ref);
+
+    // Popping elements that have not been migrated yet
+    for (size_t i = 0; i < 200; ++i) {
+        vec.pop_back();
+        ref.pop_back();
+        REQUIRE(collect(vec) == ref);
+    }
+    REQUIRE(!vec.migrating());
+
+    // Growing again while still migrating finishes the migration first
+    for (size_t i = 0; i < 1000; ++i) {
+        vec.emplace_back(vec[i % vec.size()]);
+        ref.push_back(ref[i % ref.size()]);
+    }
+    REQUIRE(collect(vec) == ref);
+    vec.reserve(4096);
+    vec.reserve(8192);
+    REQUIRE(collect(vec) == ref);
+}
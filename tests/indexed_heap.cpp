@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/generational_index.hpp>
+#include <cppasta/indexed_heap.hpp>
+
+using namespace pasta;
+
+using Key = CompositeId<void>;
+
+TEST_CASE("IndexedHeap basics", "[indexed_heap]")
+{
+    IndexedHeap<Key, float> heap;
+    heap.push(Key(0, 1), 5.0f);
+    heap.push(Key(1, 1), 3.0f);
+    heap.push(Key(2, 1), 4.0f);
+    REQUIRE(heap.size() == 3);
+    REQUIRE(heap.top().key == Key(1, 1));
+
+    // decrease-key
+    REQUIRE(heap.update(Key(0, 1), 1.0f));
+    REQUIRE(heap.top().key == Key(0, 1));
+    // increase-key
+    REQUIRE(heap.update(Key(0, 1), 10.0f));
+    REQUIRE(heap.top().key == Key(1, 1));
+
+    // Stale generation
+    REQUIRE(!heap.contains(Key(2, 2)));
+    REQUIRE(!heap.update(Key(2, 2), 0.0f));
+    REQUIRE(!heap.erase(Key(2, 2)));
+
+    REQUIRE(heap.erase(Key(2, 1)));
+    REQUIRE(*heap.find(Key(0, 1)) == 10.0f);
+    REQUIRE(heap.find(Key(2, 1)) == nullptr);
+
+    REQUIRE(heap.pop().key == Key(1, 1));
+    REQUIRE(!heap.push_or_update(Key(0, 1), 2.0f));
+    REQUIRE(heap.push_or_update(Key(2, 2), 1.0f));
+    REQUIRE(heap.pop().key == Key(2, 2));
+    REQUIRE(heap.pop().key == Key(0, 1));
+    REQUIRE(heap.empty());
+}
+
+TEST_CASE("IndexedHeap max-heap with string priorities", "[indexed_heap]")
+{
+    IndexedHeap<Key, std::string, std::greater<std::string>> heap;
+    const std::vector<std::string> prios { "m", "b", "z", "c", "y", "a", "x", "d", "q" };
+    for (size_t i = 0; i < prios.size(); ++i) {
+        heap.push(Key(static_cast<uint32_t>(i), 1), prios[i]);
+    }
+    auto sorted = prios;
+    std::sort(sorted.begin(), sorted.end(), std::greater<std::string>());
+    for (const auto& expected : sorted) {
+        REQUIRE(heap.pop().priority == expected);
+    }
+    REQUIRE(heap.empty());
+}
+
+TEST_CASE("IndexedHeap against reference", "[indexed_heap]")
+{
+    IndexedHeap<Key, uint32_t> heap;
+    std::map<uint32_t, uint32_t> ref; // idx -> priority
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < 50'000; ++i) {
+        const auto idx = rng() % 500;
+        const auto prio = rng() % 1000;
+        switch (rng() % 4) {
+        case 0:
+            REQUIRE(heap.push_or_update(Key(idx, 1), prio) == !ref.contains(idx));
+            ref[idx] = prio;
+            break;
+        case 1:
+            REQUIRE(heap.update(Key(idx, 1), prio) == ref.contains(idx));
+            if (ref.contains(idx)) {
+                ref[idx] = prio;
+            }
+            break;
+        case 2:
+            REQUIRE(heap.erase(Key(idx, 1)) == (ref.erase(idx) > 0));
+            break;
+        case 3:
+            if (!heap.empty()) {
+                const auto entry = heap.pop();
+                const auto min = std::min_element(ref.begin(), ref.end(),
+                    [](const auto& a, const auto& b) { return a.second < b.second; });
+                REQUIRE(entry.priority == min->second);
+                REQUIRE(ref.at(entry.key.idx()) == entry.priority);
+                ref.erase(entry.key.idx());
+            }
+            break;
+        }
+        REQUIRE(heap.size() == ref.size());
+    }
+    heap.clear();
+    REQUIRE(heap.empty());
+    REQUIRE(!heap.contains(Key(0, 1)));
+}
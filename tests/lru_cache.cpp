@@ -0,0 +1,85 @@
+#include <string>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/lru_cache.hpp>
+
+using namespace pasta;
+
+TEST_CASE("LruCache", "[lru_cache]")
+{
+    LruCache<int, std::string> cache(3);
+    cache.put(1, "one");
+    cache.put(2, "two");
+    cache.put(3, "three");
+    REQUIRE(cache.size() == 3);
+    REQUIRE(*cache.lru() == 1);
+
+    // Touch 1, so 2 is evicted next
+    REQUIRE(*cache.get(1) == "one");
+    REQUIRE(*cache.lru() == 2);
+    cache.put(4, "four");
+    REQUIRE(cache.size() == 3);
+    REQUIRE(!cache.contains(2));
+    REQUIRE(cache.get(2) == nullptr);
+
+    // peek does not update recency
+    REQUIRE(*cache.peek(3) == "three");
+    cache.put(5, "five");
+    REQUIRE(!cache.contains(3));
+
+    // Overwriting makes the entry most recently used
+    cache.put(1, "uno");
+    cache.put(6, "six");
+    REQUIRE(!cache.contains(4));
+    REQUIRE(*cache.get(1) == "uno");
+
+    REQUIRE(cache.erase(5));
+    REQUIRE(!cache.erase(5));
+    REQUIRE(cache.size() == 2);
+    cache.put(7, "seven");
+    cache.put(8, "eight");
+    REQUIRE(!cache.contains(6));
+    REQUIRE(cache.contains(1));
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.lru() == nullptr);
+    cache.put(9, "nine");
+    REQUIRE(*cache.get(9) == "nine");
+}
+
+TEST_CASE("ClockCache", "[lru_cache]")
+{
+    ClockCache<int, int> cache(3);
+    cache.put(1, 10);
+    cache.put(2, 20);
+    cache.put(3, 30);
+
+    // Referenced entries get a second chance
+    REQUIRE(*cache.get(1) == 10);
+    REQUIRE(*cache.get(3) == 30);
+    cache.put(4, 40);
+    REQUIRE(!cache.contains(2));
+    REQUIRE(cache.contains(1));
+    REQUIRE(cache.contains(3));
+    REQUIRE(cache.size() == 3);
+
+    // No entry is referenced anymore (the hand cleared all flags), so the hand evicts the next one
+    cache.put(5, 50);
+    REQUIRE(cache.size() == 3);
+    REQUIRE(cache.contains(5));
+
+    // Many more insertions than capacity
+    for (int i = 100; i < 1000; ++i) {
+        cache.put(i, i);
+        REQUIRE(*cache.peek(i) == i);
+        REQUIRE(cache.size() <= 3);
+    }
+
+    REQUIRE(cache.erase(999));
+    REQUIRE(cache.size() == 2);
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+}
@@ -0,0 +1,122 @@
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/dense_slot_map.hpp>
+#include <cppasta/parallel.hpp>
+#include <cppasta/views.hpp>
+
+using namespace pasta;
+
+TEST_CASE("ThreadPool", "[parallel]")
+{
+    ThreadPool pool(3);
+    REQUIRE(pool.num_workers() == 3);
+
+    std::vector<std::atomic<int>> counts(1000);
+    pool.run(counts.size(), [&](size_t i) { counts[i]++; });
+    for (const auto& c : counts) {
+        REQUIRE(c == 1);
+    }
+
+    // Nested runs are executed serially
+    std::atomic<int> total = 0;
+    pool.run(8, [&](size_t) { pool.run(8, [&](size_t) { total++; }); });
+    REQUIRE(total == 64);
+
+    // The first exception is rethrown, but every chunk is still executed
+    std::atomic<int> executed = 0;
+    REQUIRE_THROWS_AS(pool.run(100,
+                          [&](size_t i) {
+                              executed++;
+                              if (i % 10 == 0) {
+                                  throw std::runtime_error("chunk failed");
+                              }
+                          }),
+        std::runtime_error);
+    REQUIRE(executed == 100);
+
+    // The pool is still usable afterwards
+    total = 0;
+    pool.run(10, [&](size_t) { total++; });
+    REQUIRE(total == 10);
+}
+
+TEST_CASE("Parallel algorithms", "[parallel]")
+{
+    ThreadPool pool(3);
+    std::vector<int64_t> values(10007);
+    std::iota(values.begin(), values.end(), -100);
+
+    std::vector<int64_t> squares(values.size());
+    parallel::transform_into(values, squares, [](int64_t v) { return v * v; }, 100, pool);
+    for (size_t i = 0; i < values.size(); ++i) {
+        REQUIRE(squares[i] == values[i] * values[i]);
+    }
+
+    const auto sum = std::accumulate(values.begin(), values.end(), int64_t(0));
+    REQUIRE(parallel::reduce(values, int64_t(0), std::plus<>(), 100, pool) == sum);
+    REQUIRE(parallel::reduce(values, int64_t(0), std::plus<>(), 1, pool) == sum);
+    REQUIRE(parallel::reduce(values, int64_t(0), std::plus<>(), 1000000, pool) == sum);
+    REQUIRE(parallel::transform_reduce(
+                values, int64_t(7), std::plus<>(), [](int64_t v) { return v * 2; }, 64, pool)
+        == 7 + 2 * sum);
+    REQUIRE(parallel::reduce(std::vector<int64_t> {}, int64_t(5)) == 5);
+
+    std::vector<int64_t> expected(values.size()), scan(values.size());
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+    parallel::inclusive_scan(values, scan, std::plus<>(), 99, pool);
+    REQUIRE(scan == expected);
+
+    std::exclusive_scan(values.begin(), values.end(), expected.begin(), int64_t(3));
+    parallel::exclusive_scan(values, scan, int64_t(3), std::plus<>(), 99, pool);
+    REQUIRE(scan == expected);
+
+    // In place
+    scan = values;
+    parallel::exclusive_scan(scan, scan, int64_t(3), std::plus<>(), 99, pool);
+    REQUIRE(scan == expected);
+
+    parallel::for_each(values, [](int64_t& v) { v = -v; }, 128, pool);
+    REQUIRE(values[200] == -100);
+}
+
+TEST_CASE("Parallel reduce is deterministic", "[parallel]")
+{
+    std::vector<float> values(100000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = 1.0f / static_cast<float>(i + 1);
+    }
+    ThreadPool one(0), many(5);
+    const auto a = parallel::reduce(values, 0.0f, std::plus<>(), 1000, one);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(parallel::reduce(values, 0.0f, std::plus<>(), 1000, many) == a);
+    }
+}
+
+TEST_CASE("Parallel algorithms on views and slot maps", "[parallel]")
+{
+    ThreadPool pool(2);
+    struct Entity {
+        float health;
+    };
+    DenseSlotMap<Entity, std::vector, std::vector> entities(1000);
+    for (int i = 0; i < 1000; ++i) {
+        entities.insert(Entity { static_cast<float>(i % 10) });
+    }
+    const auto total = parallel::transform_reduce(
+        entities, 0.0f, std::plus<>(), [](const Entity& e) { return e.health; }, 64, pool);
+    REQUIRE(total == 4500.0f);
+    parallel::for_each(entities, [](Entity& e) { e.health = 1.0f; }, 64, pool);
+    REQUIRE(entities.begin()->health == 1.0f);
+
+    std::vector<int> values(100, 1);
+    RangeView view(values, 10, 50);
+    REQUIRE(parallel::reduce(view, 0, std::plus<>(), 7, pool) == 50);
+    parallel::for_each(view, [](int& v) { v = 2; }, 7, pool);
+    REQUIRE(std::accumulate(values.begin(), values.end(), 0) == 150);
+}
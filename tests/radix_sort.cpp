@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/generational_index.hpp>
+#include <cppasta/radix_sort.hpp>
+
+using namespace pasta;
+
+template <typename T>
+std::vector<T> random_keys(size_t n, T max_value, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<T> dist(std::numeric_limits<T>::min(), max_value);
+    std::vector<T> keys(n);
+    for (auto& key : keys) {
+        key = dist(rng);
+    }
+    return keys;
+}
+
+template <typename T>
+void test_keys(T max_value)
+{
+    for (const size_t n : { 0, 1, 2, 50, 256, 257, 1000, 100'000 }) {
+        auto keys = random_keys<T>(n, max_value, n);
+        auto expected = keys;
+        std::sort(expected.begin(), expected.end());
+        radix_sort(keys);
+        REQUIRE(keys == expected);
+    }
+}
+
+TEST_CASE("radix_sort keys", "[radix_sort]")
+{
+    test_keys<uint32_t>(std::numeric_limits<uint32_t>::max());
+    test_keys<uint64_t>(std::numeric_limits<uint64_t>::max());
+    test_keys<int32_t>(std::numeric_limits<int32_t>::max());
+    test_keys<int64_t>(std::numeric_limits<int64_t>::max());
+    test_keys<uint16_t>(std::numeric_limits<uint16_t>::max());
+    // Only the lower digits differ, so the upper passes are skipped
+    test_keys<uint64_t>(1000);
+
+    std::vector<int> sorted(10'000);
+    std::iota(sorted.begin(), sorted.end(), -5000);
+    auto keys = sorted;
+    std::reverse(keys.begin(), keys.end());
+    radix_sort(keys);
+    REQUIRE(keys == sorted);
+}
+
+TEST_CASE("radix_sort key-value", "[radix_sort]")
+{
+    for (const size_t n : { 0, 10, 64, 65, 5000 }) {
+        // Few distinct keys, so stability matters
+        const auto keys = random_keys<uint32_t>(n, 20, n);
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(
+            order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+        auto sorted_keys = keys;
+        std::vector<size_t> values(n);
+        std::iota(values.begin(), values.end(), 0);
+        radix_sort(sorted_keys, values);
+        REQUIRE(values == order);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(sorted_keys[i] == keys[values[i]]);
+        }
+    }
+}
+
+TEST_CASE("radix_sort_by", "[radix_sort]")
+{
+    using Id = CompositeId<>;
+    for (const size_t n : { 30, 3000 }) {
+        const auto idx = random_keys<uint32_t>(n, 100'000, n);
+        std::vector<Id> ids;
+        for (size_t i = 0; i < n; ++i) {
+            ids.emplace_back(idx[i], static_cast<uint32_t>(i));
+        }
+        auto expected = ids;
+        std::stable_sort(expected.begin(), expected.end(),
+            [](const Id& a, const Id& b) { return a.idx() < b.idx(); });
+        radix_sort_by(ids, [](const Id& id) { return id.idx(); });
+        REQUIRE(ids == expected);
+    }
+}
+
+struct Item {
+    uint32_t key;
+    size_t order;
+};
+
+// Moved-from unique_ptrs are null, so this fails if a key is read from an item that was moved out
+static void test_move_only(ThreadPool* pool)
+{
+    const size_t n = 10'000;
+    const auto keys = random_keys<uint32_t>(n, 60'000, n);
+    std::vector<std::unique_ptr<Item>> items;
+    for (size_t i = 0; i < n; ++i) {
+        items.push_back(std::make_unique<Item>(keys[i], i));
+    }
+    const auto key = [](const std::unique_ptr<Item>& p) { return p->key; };
+    if (pool) {
+        parallel::radix_sort_by(items, key, *pool, 1000);
+    } else {
+        radix_sort_by(items, key);
+    }
+    for (size_t i = 1; i < n; ++i) {
+        REQUIRE(items[i - 1]->key <= items[i]->key);
+        if (items[i - 1]->key == items[i]->key) {
+            REQUIRE(items[i - 1]->order < items[i]->order);
+        }
+    }
+}
+
+TEST_CASE("radix_sort_by move-only", "[radix_sort]")
+{
+    test_move_only(nullptr);
+    ThreadPool pool(3);
+    test_move_only(&pool);
+}
+
+TEST_CASE("parallel::radix_sort", "[radix_sort]")
+{
+    ThreadPool pool(3);
+    for (const size_t n : { 100, 10'000, 200'000 }) {
+        auto keys = random_keys<uint64_t>(n, std::numeric_limits<uint64_t>::max(), n);
+        auto expected = keys;
+        std::sort(expected.begin(), expected.end());
+        parallel::radix_sort(keys, pool, 1000);
+        REQUIRE(keys == expected);
+
+        const auto small_keys = random_keys<int32_t>(n, 50, n + 1);
+        auto serial_keys = small_keys;
+        std::vector<uint32_t> serial_values(n);
+        std::iota(serial_values.begin(), serial_values.end(), 0);
+        radix_sort(serial_keys, serial_values);
+
+        auto parallel_keys = small_keys;
+        std::vector<uint32_t> parallel_values(n);
+        std::iota(parallel_values.begin(), parallel_values.end(), 0);
+        parallel::radix_sort(parallel_keys, parallel_values, pool, 1000);
+        REQUIRE(parallel_keys == serial_keys);
+        REQUIRE(parallel_values == serial_values);
+
+        std::vector<std::pair<uint32_t, uint32_t>> pairs(n);
+        for (size_t i = 0; i < n; ++i) {
+            pairs[i] = { static_cast<uint32_t>(small_keys[i] + 50), static_cast<uint32_t>(i) };
+        }
+        auto expected_pairs = pairs;
+        std::stable_sort(expected_pairs.begin(), expected_pairs.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        parallel::radix_sort_by(
+            pairs, [](const auto& p) { return p.first; }, pool, 1000);
+        REQUIRE(pairs == expected_pairs);
+    }
+}
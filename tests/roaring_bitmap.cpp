@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/roaring_bitmap.hpp>
+
+using namespace pasta;
+
+using Set = std::set<uint32_t>;
+
+static std::vector<uint32_t> to_vector(const Set& set)
+{
+    return std::vector<uint32_t>(set.begin(), set.end());
+}
+
+// Mixes sparse values, a dense chunk and a long range, so all container types are involved
+static Set random_set(std::mt19937& rng)
+{
+    Set set;
+    std::uniform_int_distribution<uint32_t> sparse(0, 1 << 20);
+    for (int i = 0; i < 2000; ++i) {
+        set.insert(sparse(rng));
+    }
+    std::uniform_int_distribution<uint32_t> dense(3 << 16, (4 << 16) - 1);
+    for (int i = 0; i < 20000; ++i) {
+        set.insert(dense(rng));
+    }
+    const auto start = std::uniform_int_distribution<uint32_t>(0, 1 << 20)(rng);
+    for (uint32_t v = start; v < start + 70000; ++v) {
+        set.insert(v);
+    }
+    return set;
+}
+
+static RoaringBitmap to_bitmap(const Set& set, bool optimize)
+{
+    RoaringBitmap bitmap;
+    const auto values = to_vector(set);
+    bitmap.add_many(values);
+    if (optimize) {
+        bitmap.run_optimize();
+    }
+    return bitmap;
+}
+
+TEST_CASE("RoaringBitmap basic", "[roaring_bitmap]")
+{
+    RoaringBitmap bitmap { 5, 1, 70000, 1 };
+    REQUIRE(bitmap.size() == 3);
+    REQUIRE(bitmap.contains(1));
+    REQUIRE(bitmap.contains(70000));
+    REQUIRE(!bitmap.contains(2));
+    REQUIRE(bitmap.add(2));
+    REQUIRE(!bitmap.add(2));
+    REQUIRE(bitmap.to_vector() == std::vector<uint32_t> { 1, 2, 5, 70000 });
+    REQUIRE(*bitmap.min() == 1);
+    REQUIRE(*bitmap.max() == 70000);
+    REQUIRE(bitmap.remove(70000));
+    REQUIRE(!bitmap.remove(70000));
+    REQUIRE(*bitmap.max() == 5);
+    bitmap.clear();
+    REQUIRE(bitmap.empty());
+    REQUIRE(!bitmap.min());
+
+    // Array -> bitmap -> array
+    for (uint32_t i = 0; i < 5000; ++i) {
+        bitmap.add(i * 2);
+    }
+    REQUIRE(bitmap.size() == 5000);
+    REQUIRE(*bitmap.max() == 9998);
+    for (uint32_t i = 0; i < 4000; ++i) {
+        REQUIRE(bitmap.remove(i * 2));
+    }
+    REQUIRE(bitmap.size() == 1000);
+    REQUIRE(*bitmap.min() == 8000);
+    REQUIRE(bitmap.contains(9998));
+    REQUIRE(!bitmap.contains(9999));
+}
+
+TEST_CASE("RoaringBitmap ranges and runs", "[roaring_bitmap]")
+{
+    RoaringBitmap bitmap;
+    bitmap.add_range(10, 200000);
+    REQUIRE(bitmap.size() == 200000 - 10);
+    REQUIRE(!bitmap.contains(9));
+    REQUIRE(bitmap.contains(10));
+    REQUIRE(bitmap.contains(199999));
+    REQUIRE(!bitmap.contains(200000));
+    REQUIRE(bitmap.memory_usage() < 1000);
+
+    // Adding to a run converts it
+    REQUIRE(bitmap.add(300000));
+    REQUIRE(!bitmap.add(100));
+    REQUIRE(bitmap.remove(100));
+    REQUIRE(!bitmap.contains(100));
+    REQUIRE(bitmap.size() == 200000 - 10);
+    REQUIRE(bitmap.run_optimize());
+    REQUIRE(bitmap.memory_usage() < 1000);
+    REQUIRE(bitmap.contains(99));
+    REQUIRE(!bitmap.contains(100));
+    REQUIRE(bitmap.contains(101));
+    REQUIRE(*bitmap.max() == 300000);
+
+    RoaringBitmap expected;
+    for (uint32_t v = 10; v < 200000; ++v) {
+        if (v != 100) {
+            expected.add(v);
+        }
+    }
+    expected.add(300000);
+    REQUIRE(bitmap == expected);
+
+    RoaringBitmap full;
+    full.add_range(0, uint64_t(1) << 32);
+    REQUIRE(full.size() == uint64_t(1) << 32);
+    REQUIRE(*full.max() == 0xffffffff);
+}
+
+TEST_CASE("RoaringBitmap set operations", "[roaring_bitmap]")
+{
+    std::mt19937 rng(7);
+    for (int round = 0; round < 4; ++round) {
+        const auto a = random_set(rng);
+        const auto b = random_set(rng);
+        const auto ra = to_bitmap(a, round & 1);
+        const auto rb = to_bitmap(b, round & 2);
+        REQUIRE(ra.to_vector() == to_vector(a));
+        REQUIRE(ra.size() == a.size());
+
+        std::vector<uint32_t> expected;
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        REQUIRE((ra | rb).to_vector() == expected);
+
+        expected.clear();
+        std::set_intersection(
+            a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        REQUIRE((ra & rb).to_vector() == expected);
+        REQUIRE(ra.intersection_size(rb) == expected.size());
+        REQUIRE(ra.intersects(rb) == !expected.empty());
+
+        expected.clear();
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+        REQUIRE((ra - rb).to_vector() == expected);
+
+        REQUIRE((ra - ra).empty());
+        REQUIRE((ra & ra) == ra);
+        REQUIRE((ra | ra) == ra);
+    }
+
+    // Very different sizes (galloping)
+    RoaringBitmap small { 3, 500, 4000 };
+    RoaringBitmap large;
+    for (uint32_t v = 0; v < 4000; v += 2) {
+        large.add(v);
+    }
+    REQUIRE((small & large).to_vector() == std::vector<uint32_t> { 500 });
+    REQUIRE((large & small).to_vector() == std::vector<uint32_t> { 500 });
+}
+
+TEST_CASE("RoaringBitmap serialization", "[roaring_bitmap]")
+{
+    std::mt19937 rng(3);
+    auto bitmap = to_bitmap(random_set(rng), false);
+    bitmap.add_range(1 << 24, (1 << 24) + 100000);
+    const auto data = bitmap.serialize();
+    const auto copy = RoaringBitmap::deserialize(data);
+    REQUIRE(copy);
+    REQUIRE(*copy == bitmap);
+    REQUIRE(copy->to_vector() == bitmap.to_vector());
+
+    REQUIRE(bitmap.run_optimize());
+    const auto optimized = bitmap.serialize();
+    REQUIRE(optimized.size() < data.size());
+    REQUIRE(*RoaringBitmap::deserialize(optimized) == bitmap);
+
+    REQUIRE(!RoaringBitmap::deserialize(std::span(optimized).first(optimized.size() - 1)));
+    auto corrupt = optimized;
+    corrupt[0] ^= 1;
+    REQUIRE(!RoaringBitmap::deserialize(corrupt));
+    REQUIRE(RoaringBitmap::deserialize(RoaringBitmap().serialize())->empty());
+}
@@ -113,6 +113,14 @@ void test_common_set_skipped()
 
     sf.resize(12, true);
     REQUIRE(collect(sf) == V { 4, 5 });
+
+    sf.set_all_skipped();
+    CAPTURE(skipped(sf));
+    REQUIRE(collect(sf) == V {});
+
+    sf.set_not_skipped(6);
+    CAPTURE(skipped(sf));
+    REQUIRE(collect(sf) == V { 6 });
 }
 
 TEST_CASE("IntSkipfield - set skipped", "[skipfield]")
@@ -133,4 +141,14 @@ TEST_CASE("BoolSkipfield - set skipped", "[skipfield]")
 TEST_CASE("BoolSkipfield - set not skipped", "[skipfield]")
 {
     test_common_set_not_skipped<BoolSkipfield<std::vector>>();
-}
\ No newline at end of file
+}
+
+TEST_CASE("BitSkipfield - set skipped", "[skipfield]")
+{
+    test_common_set_skipped<BitSkipfield>();
+}
+
+TEST_CASE("BitSkipfield - set not skipped", "[skipfield]")
+{
+    test_common_set_not_skipped<BitSkipfield>();
+}
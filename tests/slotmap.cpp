@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
@@ -5,6 +8,7 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include <cppasta/dense_slot_map.hpp>
+#include <cppasta/incremental_vector.hpp>
 #include <cppasta/slot_map.hpp>
 
 using namespace pasta;
@@ -58,6 +62,16 @@ using GrowableStorage = GrowableSlotMapStorage<T, Key, std::vector<uint32_t>, st
 template <typename T, typename Key>
 using PagedStorage = PagedSlotMapStorage<T, Key, std::vector<uint32_t>, std::allocator>;
 
+template <typename T, typename Key>
+using NarrowStorage = GrowableSlotMapStorage<T, Key, std::vector<uint8_t>, std::allocator>;
+
+template <typename T, typename Key>
+using PackedStorage = PagedSlotMapStorage<T, Key, PackedGenerations<3>, std::allocator>;
+
+// A small step, so the migration takes a while
+template <typename T, typename Key>
+using IncrementalStorage = IncrementalSlotMapStorage<T, Key, std::allocator, 2>;
+
 template <typename S>
 void test_slot_map()
 {
@@ -113,6 +127,235 @@ TEST_CASE("SlotMap<PagedStorage>", "[slotmap]")
     test_slot_map<SlotMap<std::string, PagedStorage>>();
 }
 
+TEST_CASE("SlotMap<NarrowStorage>", "[slotmap]")
+{
+    test_slot_map<SlotMap<std::string, NarrowStorage>>();
+}
+
+TEST_CASE("SlotMap<PackedStorage>", "[slotmap]")
+{
+    test_slot_map<SlotMap<std::string, PackedStorage>>();
+}
+
+TEST_CASE("SlotMap<IncrementalStorage>", "[slotmap]")
+{
+    test_slot_map<SlotMap<std::string, IncrementalStorage>>();
+    test_slot_map<SlotMap<std::string, IncrementalStorage, CompositeId<std::string>,
+        BitSkipfield>>();
+}
+
+template <typename S>
+void test_incremental_growth()
+{
+    S sm(4, 0, 2.0f);
+    std::vector<std::pair<typename S::Key, std::string>> live;
+    std::vector<typename S::Key> removed;
+    // Deterministic pseudo-random mix of inserts and removes, so lookups, removes and inserts all
+    // happen in the middle of migrations
+    uint32_t state = 12345;
+    for (size_t i = 0; i < 2000; ++i) {
+        state = state * 1664525 + 1013904223;
+        if (!live.empty() && (state >> 16) % 3 == 0) {
+            const auto idx = (state >> 8) % live.size();
+            REQUIRE(sm.remove(live[idx].first));
+            removed.push_back(live[idx].first);
+            live[idx] = live.back();
+            live.pop_back();
+        } else {
+            const auto value = std::to_string(i) + " is long enough to not be stored inline";
+            live.emplace_back(sm.insert(value), value);
+        }
+        for (const auto& [key, value] : live) {
+            REQUIRE(sm.contains(key));
+            REQUIRE(*sm.get(key) == value);
+        }
+    }
+    for (const auto& key : removed) {
+        REQUIRE(!sm.contains(key));
+    }
+    std::unordered_set<std::string> values;
+    for (const auto& [key, value] : live) {
+        values.insert(value);
+    }
+    if constexpr (requires { sm.next({}); }) {
+        REQUIRE(collect(sm) == values);
+    } else {
+        REQUIRE(std::unordered_set<std::string>(sm.begin(), sm.end()) == values);
+    }
+    REQUIRE(sm.size() == live.size());
+}
+
+TEST_CASE("incremental growth", "[slotmap]")
+{
+    test_incremental_growth<SlotMap<std::string, IncrementalStorage>>();
+    test_incremental_growth<SlotMap<std::string, IncrementalStorage, CompositeId<std::string>,
+        BitSkipfield>>();
+    test_incremental_growth<DenseSlotMap<std::string, IncrementalVector, IncrementalVector>>();
+}
+
+template <typename T, typename Key>
+using InlineStorage = InlineSlotMapStorage<T, Key, 16>;
+
+TEST_CASE("SlotMap<InlineStorage>", "[slotmap]")
+{
+    // test_slot_map needs to grow
+    SlotMap<std::string, InlineStorage> sm(16);
+    REQUIRE(sm.capacity() == 16);
+    std::vector<SlotMap<std::string, InlineStorage>::Key> keys;
+    for (size_t i = 0; i < 16; ++i) {
+        keys.push_back(sm.insert(std::to_string(i)));
+    }
+    REQUIRE(sm.remove(keys[3]));
+    const auto key = sm.emplace("xxxxx", size_t(3));
+    REQUIRE(key.idx() == 3);
+    REQUIRE(*sm.get(key) == "xxx");
+    REQUIRE(!sm.contains(keys[3]));
+    REQUIRE(collect(sm).size() == 16);
+    sm.clear();
+    REQUIRE(sm.size() == 0);
+    REQUIRE(sm.insert("foo").idx() == 0);
+}
+
+constexpr int constexpr_slot_map()
+{
+    SlotMap<int, InlineStorage, CompositeId<int>> sm(16);
+    const auto a = sm.insert(1);
+    const auto b = sm.emplace(2);
+    sm.remove(a);
+    const auto c = sm.insert(3);
+    int sum = 0;
+    for (auto key = sm.next({}); key; key = sm.next(key)) {
+        sum += *sm.get(key);
+    }
+    return sum + *sm.get(b) * 10 + (sm.contains(a) ? 100 : 0) + (c.idx() == a.idx() ? 1000 : 0);
+}
+
+static_assert(constexpr_slot_map() == 1025);
+
+template <typename T, typename Key>
+using NarrowInlineStorage = InlineSlotMapStorage<T, Key, 64, uint8_t>;
+
+constinit SlotMap<int, NarrowInlineStorage> global_slot_map(64);
+
+TEST_CASE("constinit SlotMap", "[slotmap]")
+{
+    const auto key = global_slot_map.insert(42);
+    REQUIRE(*global_slot_map.get(key) == 42);
+    REQUIRE(global_slot_map.remove(key));
+    REQUIRE(global_slot_map.size() == 0);
+}
+
+template <typename T, typename Key>
+using NarrowPagedStorage = PagedSlotMapStorage<T, Key, std::vector<uint8_t>, std::allocator>;
+
+template <typename S>
+void test_cached_handle()
+{
+    S sm(4, 4);
+    REQUIRE(!decltype(sm.cache({}))().valid());
+
+    const auto foo = sm.insert("foo");
+    const auto bar = sm.insert("bar");
+    auto foo_handle = sm.cache(foo);
+    const auto bar_handle = sm.cache(bar);
+    REQUIRE(foo_handle.key() == foo);
+    REQUIRE(foo_handle.valid());
+    REQUIRE(*foo_handle == "foo");
+    REQUIRE(foo_handle->size() == 3);
+    REQUIRE(foo_handle.get() == sm.get(foo));
+
+    // Adding pages doesn't invalidate handles
+    std::vector<typename S::Key> keys;
+    for (size_t i = 0; i < 20; ++i) {
+        keys.push_back(sm.insert(std::to_string(i)));
+    }
+    REQUIRE(sm.capacity() > 4);
+    REQUIRE(foo_handle.get() == sm.get(foo));
+    REQUIRE(*bar_handle == "bar");
+    REQUIRE(*sm.cache(keys[19]) == "19");
+
+    // Removing (and reusing the slot) does
+    REQUIRE(sm.remove(foo));
+    REQUIRE(!foo_handle);
+    REQUIRE(foo_handle.get() == nullptr);
+    REQUIRE(!sm.cache(foo).valid());
+    const auto baz = sm.insert("baz");
+    REQUIRE(baz.idx() == foo.idx());
+    REQUIRE(!foo_handle.valid());
+    foo_handle = sm.cache(baz);
+    REQUIRE(*foo_handle == "baz");
+
+    sm.clear();
+    REQUIRE(!foo_handle.valid());
+    REQUIRE(!bar_handle.valid());
+}
+
+TEST_CASE("CachedHandle", "[slotmap]")
+{
+    test_cached_handle<SlotMap<std::string, PagedStorage>>();
+    test_cached_handle<SlotMap<std::string, NarrowPagedStorage>>();
+}
+
+template <size_t Bits>
+void test_packed_generations()
+{
+    PackedGenerations<Bits> gens(3, 0);
+    std::vector<uint32_t> ref(3, 0);
+    gens.resize(200, 1);
+    ref.resize(200, 1);
+    uint64_t rng = 12345;
+    for (size_t i = 0; i < 2000; ++i) {
+        rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+        const auto idx = static_cast<size_t>(rng >> 33) % ref.size();
+        const auto value = static_cast<uint32_t>(rng >> 7) & PackedGenerations<Bits>::max_value;
+        gens.set(idx, value);
+        ref[idx] = value;
+        // Check the neighbours too, so writes that spill over into the next word are caught
+        for (size_t j = idx > 0 ? idx - 1 : 0; j < std::min(idx + 2, ref.size()); ++j) {
+            REQUIRE(gens[j] == ref[j]);
+        }
+    }
+    for (size_t i = 0; i < ref.size(); ++i) {
+        REQUIRE(gens[i] == ref[i]);
+    }
+
+    // Resetting a prefix that doesn't end at a word boundary
+    gens.reset(101);
+    std::fill_n(ref.begin(), 101, 0);
+    for (size_t i = 0; i < ref.size(); ++i) {
+        REQUIRE(gens[i] == ref[i]);
+    }
+}
+
+TEST_CASE("PackedGenerations", "[slotmap]")
+{
+    test_packed_generations<2>();
+    test_packed_generations<5>();
+    test_packed_generations<7>();
+    test_packed_generations<13>();
+    test_packed_generations<32>();
+}
+
+TEST_CASE("narrow generations wrap around", "[slotmap]")
+{
+    SlotMap<int, PackedStorage> sm(4);
+    const auto other = sm.insert(-1);
+    std::vector<uint32_t> gens;
+    for (int i = 0; i < 20; ++i) {
+        const auto key = sm.insert(i);
+        REQUIRE(key.gen() >= 1);
+        REQUIRE(key.gen() <= 7);
+        REQUIRE(*sm.get(key) == i);
+        gens.push_back(key.gen());
+        REQUIRE(sm.remove(key));
+        REQUIRE(!sm.contains(key));
+    }
+    REQUIRE(gens[0] == 2);
+    REQUIRE(gens[5] == 7);
+    REQUIRE(gens[6] == 1);
+    REQUIRE(*sm.get(other) == -1);
+}
+
 TEST_CASE("DenseSlotMap", "[slotmap]")
 {
     using C = std::vector<std::string>;
@@ -208,4 +451,334 @@ TEST_CASE("DenseSlotMap", "[slotmap]")
         == O { "foo", "bar", {}, "bat", {}, "zop", "zip", "zep", "zap", "zup", "sup" });
     REQUIRE(
         collect_dense(sm) == C { "foo", "bar", "bat", "zop", "zap", "zep", "zip", "zup", "sup" });
-}
\ No newline at end of file
+}
+
+template <typename S>
+void test_clear()
+{
+    using V = typename S::Value;
+    S sm(8, 8);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < 20; ++i) {
+        names.push_back(std::to_string(i));
+    }
+    std::vector<typename S::Key> keys;
+    for (const auto& name : names) {
+        keys.push_back(sm.insert(V(name)));
+    }
+    REQUIRE(sm.remove(keys[3]));
+    REQUIRE(sm.remove(keys[17]));
+
+    sm.clear();
+    REQUIRE(sm.size() == 0);
+    REQUIRE(collect(sm).empty());
+    for (const auto& key : keys) {
+        REQUIRE(!sm.contains(key));
+    }
+
+    // Slots are handed out in order again, but with new generations
+    const auto a = sm.insert(V("a"));
+    const auto b = sm.insert(V("b"));
+    REQUIRE(a.idx() == 0);
+    REQUIRE(b.idx() == 1);
+    REQUIRE(!sm.contains(keys[0]));
+    REQUIRE(collect(sm) == std::unordered_set<V> { V("a"), V("b") });
+    REQUIRE(sm.remove(a));
+    REQUIRE(sm.insert(V("c")).idx() == 0);
+    REQUIRE(collect(sm) == std::unordered_set<V> { V("b"), V("c") });
+
+    // Clearing a map that is empty already
+    sm.clear();
+    sm.clear();
+    REQUIRE(sm.insert(V("d")).idx() == 0);
+}
+
+TEST_CASE("clear", "[slotmap]")
+{
+    test_clear<SlotMap<std::string, GrowableStorage>>();
+    test_clear<SlotMap<std::string, PagedStorage>>();
+    test_clear<SlotMap<std::string, IncrementalStorage>>();
+    test_clear<SlotMap<std::string, NarrowStorage>>();
+    test_clear<SlotMap<std::string, PackedStorage>>();
+    test_clear<SlotMap<std::string, GrowableStorage, CompositeId<std::string>,
+        IntSkipfield<std::vector>>>();
+    test_clear<SlotMap<std::string, GrowableStorage, CompositeId<std::string>, BitSkipfield>>();
+    // Trivially destructible
+    test_clear<SlotMap<std::string_view, GrowableStorage, CompositeId<std::string_view>,
+        IntSkipfield<std::vector>>>();
+    test_clear<SlotMap<std::string_view, IncrementalStorage, CompositeId<std::string_view>,
+        BitSkipfield>>();
+}
+
+// The free list has to survive resizing
+template <typename S>
+void test_resize_free_list()
+{
+    S sm(8);
+    std::vector<typename S::Key> keys;
+    for (int i = 0; i < 8; ++i) {
+        keys.push_back(sm.insert(std::to_string(i)));
+    }
+    REQUIRE(sm.remove(keys[2]));
+    REQUIRE(sm.remove(keys[5]));
+    sm.resize(16);
+    const auto a = sm.insert("a");
+    const auto b = sm.insert("b");
+    const auto c = sm.insert("c");
+    REQUIRE(a.idx() == 5);
+    REQUIRE(b.idx() == 2);
+    REQUIRE(c.idx() == 8);
+    REQUIRE(map_keys(sm, { keys[0], keys[2], a, b, c })
+        == std::vector<std::optional<std::string>> { "0", {}, "a", "b", "c" });
+}
+
+TEST_CASE("resize keeps the free list", "[slotmap]")
+{
+    test_resize_free_list<SlotMap<std::string, GrowableStorage>>();
+    test_resize_free_list<SlotMap<std::string, NarrowStorage>>();
+    test_resize_free_list<SlotMap<std::string, PagedStorage>>();
+    test_resize_free_list<SlotMap<std::string, IncrementalStorage>>();
+}
+
+template <typename S>
+void test_lazy_init()
+{
+    // Nothing is initialized up front, so this shouldn't take long or use a lot of memory
+    S sm(1 << 24);
+    REQUIRE(sm.capacity() == 1 << 24);
+    std::vector<typename S::Key> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back(sm.insert(i));
+        REQUIRE(keys.back().idx() == static_cast<size_t>(i));
+    }
+    REQUIRE(!sm.contains(typename S::Key(5000, 1)));
+    REQUIRE(!sm.contains(typename S::Key(100, 1)));
+
+    // Removed slots are reused first (last removed first), then new ones are appended
+    REQUIRE(sm.remove(keys[10]));
+    REQUIRE(sm.remove(keys[20]));
+    const auto a = sm.insert(1000);
+    const auto b = sm.insert(1001);
+    const auto c = sm.insert(1002);
+    REQUIRE(a.idx() == 20);
+    REQUIRE(b.idx() == 10);
+    REQUIRE(c.idx() == 100);
+    REQUIRE(!sm.contains(keys[10]));
+    REQUIRE(!sm.contains(keys[20]));
+    REQUIRE(*sm.get(a) == 1000);
+    REQUIRE(*sm.get(b) == 1001);
+    REQUIRE(*sm.get(c) == 1002);
+    REQUIRE(*sm.get(keys[99]) == 99);
+    REQUIRE(sm.size() == 101);
+}
+
+// Counts the bytes allocated for generations
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        allocated += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    bool operator==(const CountingAllocator&) const = default;
+
+    static inline size_t allocated = 0;
+};
+
+template <typename T, typename Key>
+using CountingPagedStorage = PagedSlotMapStorage<T, Key,
+    std::vector<uint32_t, CountingAllocator<uint32_t>>, std::allocator>;
+
+TEST_CASE("lazy initialization", "[slotmap]")
+{
+    test_lazy_init<SlotMap<int, GrowableStorage>>();
+    test_lazy_init<SlotMap<int, PagedStorage>>();
+    test_lazy_init<SlotMap<int, GrowableStorage, CompositeId<int>, IntSkipfield<std::vector>>>();
+    test_lazy_init<DenseSlotMap<int, std::vector, std::vector>>();
+
+    CountingAllocator<uint32_t>::allocated = 0;
+    test_lazy_init<SlotMap<int, CountingPagedStorage>>();
+    REQUIRE(CountingAllocator<uint32_t>::allocated < 64 * 1024);
+
+    // Growing only initializes the new slots as they are needed
+    SlotMap<int, GrowableStorage, CompositeId<int>, BitSkipfield> sm(100, 1 << 24);
+    std::vector<CompositeId<int>> keys;
+    for (int i = 0; i < 300; ++i) {
+        keys.push_back(sm.insert(i));
+    }
+    REQUIRE(sm.capacity() == 100 + (1 << 24));
+    for (int i = 0; i < 300; ++i) {
+        REQUIRE(*sm.get(keys[i]) == i);
+    }
+    size_t count = 0;
+    for (auto key = sm.next({}); key; key = sm.next(key)) {
+        count++;
+    }
+    REQUIRE(count == 300);
+}
+
+template <typename S>
+void test_find_many()
+{
+    S sm(1000);
+    std::vector<typename S::Key> keys;
+    for (size_t i = 0; i < 1000; ++i) {
+        keys.push_back(sm.insert(std::to_string(i)));
+    }
+    std::vector<typename S::Key> contained;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i % 3 == 0) {
+            sm.remove(keys[i]);
+        } else {
+            contained.push_back(keys[i]);
+        }
+    }
+    // Random order, so prefetching actually makes a difference
+    std::reverse(keys.begin(), keys.end());
+    std::swap(keys[10], keys[500]);
+
+    std::vector<std::string*> found(keys.size());
+    sm.find_many(keys, found);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        REQUIRE(found[i] == sm.find(keys[i]));
+    }
+
+    const auto& csm = sm;
+    std::vector<const std::string*> got(contained.size());
+    csm.get_many(contained, got);
+    for (size_t i = 0; i < contained.size(); ++i) {
+        REQUIRE(got[i] == csm.get(contained[i]));
+    }
+
+    // Fewer keys than the prefetch distance
+    sm.find_many(std::span(keys).first(3), found);
+    REQUIRE(found[0] == sm.find(keys[0]));
+    sm.find_many({}, found);
+}
+
+TEST_CASE("find_many/get_many", "[slotmap]")
+{
+    test_find_many<SlotMap<std::string, GrowableStorage>>();
+    test_find_many<SlotMap<std::string, PagedStorage>>();
+    test_find_many<SlotMap<std::string, IncrementalStorage>>();
+    test_find_many<DenseSlotMap<std::string, std::vector, std::vector>>();
+}
+
+// Counts copies and moves, so we can check emplace doesn't do any
+struct Tracked {
+    Tracked(int v, std::string s)
+        : value(v)
+        , str(std::move(s))
+    {
+    }
+
+    Tracked(const Tracked& other)
+        : value(other.value)
+        , str(other.str)
+    {
+        copies++;
+    }
+
+    Tracked(Tracked&& other)
+        : value(other.value)
+        , str(std::move(other.str))
+    {
+        moves++;
+    }
+
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+
+    int value;
+    std::string str;
+
+    static inline size_t copies = 0;
+    static inline size_t moves = 0;
+};
+
+template <typename S>
+void test_emplace()
+{
+    S sm(2, 2);
+    Tracked::copies = 0;
+    Tracked::moves = 0;
+    const auto a = sm.emplace(1, "a long string that is not stored inline");
+    REQUIRE(Tracked::copies == 0);
+    REQUIRE(Tracked::moves == 0);
+    REQUIRE(sm.get(a)->value == 1);
+
+    const Tracked b_value(2, "b");
+    const auto b = sm.insert(b_value);
+    REQUIRE(Tracked::copies == 1);
+    REQUIRE(Tracked::moves == 0);
+
+    // Growing with an argument that refers to an element in the map
+    const auto c = sm.emplace(*sm.get(a));
+    REQUIRE(sm.size() == 3);
+    REQUIRE(sm.get(a)->str == "a long string that is not stored inline");
+    REQUIRE(sm.get(b)->value == 2);
+    REQUIRE(sm.get(c)->value == 1);
+    REQUIRE(sm.get(c)->str == sm.get(a)->str);
+}
+
+// All maps construct with parentheses, like emplace_back
+template <typename S>
+void test_emplace_parens()
+{
+    S sm(2, 2);
+    std::vector<typename S::Key> keys;
+    for (int i = 0; i < 4; ++i) {
+        keys.push_back(sm.emplace(3, 1));
+    }
+    for (const auto key : keys) {
+        REQUIRE(*sm.get(key) == std::vector<int> { 1, 1, 1 });
+    }
+}
+
+struct NonMovable {
+    NonMovable(int v)
+        : value(v)
+    {
+    }
+
+    NonMovable(const NonMovable&) = delete;
+    NonMovable(NonMovable&&) = delete;
+
+    int value;
+};
+
+TEST_CASE("emplace", "[slotmap]")
+{
+    test_emplace<SlotMap<Tracked, GrowableStorage>>();
+    test_emplace<SlotMap<Tracked, PagedStorage>>();
+    test_emplace<SlotMap<Tracked, IncrementalStorage>>();
+    test_emplace<DenseSlotMap<Tracked, std::vector, std::vector>>();
+    test_emplace<DenseSlotMap<Tracked, IncrementalVector, IncrementalVector>>();
+
+    test_emplace_parens<SlotMap<std::vector<int>, GrowableStorage>>();
+    test_emplace_parens<SlotMap<std::vector<int>, PagedStorage>>();
+    test_emplace_parens<SlotMap<std::vector<int>, IncrementalStorage>>();
+    test_emplace_parens<SlotMap<std::vector<int>, InlineStorage>>();
+    test_emplace_parens<DenseSlotMap<std::vector<int>, std::vector, std::vector>>();
+
+    SlotMap<NonMovable, PagedStorage> sm(2, 2);
+    std::vector<SlotMap<NonMovable, PagedStorage>::Key> keys;
+    for (int i = 0; i < 5; ++i) {
+        keys.push_back(sm.emplace(i));
+    }
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(sm.get(keys[i])->value == i);
+    }
+}
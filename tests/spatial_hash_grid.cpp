@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/dense_slot_map.hpp>
+#include <cppasta/spatial_hash_grid.hpp>
+
+using namespace pasta;
+
+using Key = CompositeId<void>;
+using Grid = SpatialHashGrid<Key>;
+
+static std::vector<uint32_t> indices(std::vector<Key> keys)
+{
+    std::vector<uint32_t> r;
+    for (const auto& k : keys) {
+        r.push_back(k.idx());
+    }
+    std::sort(r.begin(), r.end());
+    return r;
+}
+
+TEST_CASE("SpatialHashGrid against brute force", "[spatial_hash_grid]")
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+
+    Grid grid(5.0f);
+    std::vector<Key> keys;
+    std::vector<Grid::Point> points;
+    // Rebuild a few times with different sizes to check that reusing the buffers works
+    for (const auto n : { 1000, 10, 3000, 0, 500 }) {
+        keys.clear();
+        points.clear();
+        for (int i = 0; i < n; ++i) {
+            keys.emplace_back(i, 1);
+            points.push_back({ coord(rng), coord(rng) });
+        }
+        grid.rebuild(keys, points);
+        REQUIRE(grid.size() == static_cast<size_t>(n));
+
+        for (int q = 0; q < 50; ++q) {
+            const Grid::Point center { coord(rng), coord(rng) };
+            const auto radius = std::uniform_real_distribution<float>(0.0f, 30.0f)(rng);
+
+            std::vector<Key> found;
+            grid.query_radius(center, radius, found);
+            std::vector<uint32_t> expected;
+            for (int i = 0; i < n; ++i) {
+                const auto dx = points[i].x - center.x, dy = points[i].y - center.y;
+                if (dx * dx + dy * dy <= radius * radius) {
+                    expected.push_back(i);
+                }
+            }
+            REQUIRE(indices(found) == expected);
+
+            found.clear();
+            const Grid::Point max { center.x + radius, center.y + radius * 0.5f };
+            grid.query_aabb(center, max, found);
+            expected.clear();
+            for (int i = 0; i < n; ++i) {
+                if (points[i].x >= center.x && points[i].x <= max.x && points[i].y >= center.y
+                    && points[i].y <= max.y) {
+                    expected.push_back(i);
+                }
+            }
+            REQUIRE(indices(found) == expected);
+        }
+    }
+}
+
+TEST_CASE("SpatialHashGrid from DenseSlotMap", "[spatial_hash_grid]")
+{
+    struct Agent {
+        float x, y;
+    };
+    DenseSlotMap<Agent, std::vector, std::vector> agents(16);
+    const auto a = agents.insert(Agent { 0.0f, 0.0f });
+    const auto b = agents.insert(Agent { 1.0f, 1.0f });
+    agents.insert(Agent { 10.0f, 10.0f });
+    const auto d = agents.insert(Agent { -1.0f, 0.5f });
+    agents.remove(a);
+
+    using AgentGrid = SpatialHashGrid<decltype(agents)::Key>;
+    AgentGrid grid(2.0f);
+    grid.rebuild_from(
+        agents, [](const Agent& agent) { return AgentGrid::Point { agent.x, agent.y }; });
+    std::vector<decltype(agents)::Key> found;
+    grid.query_radius({ 0.0f, 0.0f }, 2.0f, found);
+    REQUIRE(found.size() == 2);
+    REQUIRE(std::find(found.begin(), found.end(), b) != found.end());
+    REQUIRE(std::find(found.begin(), found.end(), d) != found.end());
+}
+
+TEST_CASE("SpatialHashGrid with huge coordinates", "[spatial_hash_grid]")
+{
+    Grid grid(1.0f);
+    const std::vector<Key> keys { Key(0, 1), Key(1, 1), Key(2, 1), Key(3, 1) };
+    const std::vector<Grid::Point> positions {
+        { 1e30f, 1e30f },
+        { 2e30f, 1e30f },
+        { -1e30f, 1e30f },
+        { 0.0f, 0.0f },
+    };
+    grid.rebuild(keys, positions);
+
+    std::vector<Key> found;
+    grid.query_aabb({ 5e29f, 5e29f }, { 1.5e30f, 1.5e30f }, found);
+    REQUIRE(indices(found) == std::vector<uint32_t> { 0 });
+    found.clear();
+    grid.query_aabb({ 5e29f, 5e29f }, { 3e30f, 3e30f }, found);
+    REQUIRE(indices(found) == std::vector<uint32_t> { 0, 1 });
+    found.clear();
+    grid.query_radius({ 0.0f, 0.0f }, 1.0f, found);
+    REQUIRE(indices(found) == std::vector<uint32_t> { 3 });
+}
+
+TEST_CASE("SpatialHashGrid with huge queries", "[spatial_hash_grid]")
+{
+    Grid grid(1.0f);
+    const std::vector<Key> keys { Key(0, 1), Key(1, 1), Key(2, 1) };
+    const std::vector<Grid::Point> positions {
+        { 0.0f, 0.0f },
+        { 1e6f, -1e6f },
+        { -1e30f, 1e30f },
+    };
+    grid.rebuild(keys, positions);
+
+    std::vector<Key> found;
+    grid.query_radius({ 0.0f, 0.0f }, std::numeric_limits<float>::infinity(), found);
+    REQUIRE(indices(found) == std::vector<uint32_t> { 0, 1, 2 });
+    found.clear();
+    grid.query_aabb({ -2e9f, -2e9f }, { 2e9f, 2e9f }, found);
+    REQUIRE(indices(found) == std::vector<uint32_t> { 0, 1 });
+    found.clear();
+    grid.query_radius({ 0.0f, 0.0f }, 10.0f, found);
+    REQUIRE(indices(found) == std::vector<uint32_t> { 0 });
+}
@@ -0,0 +1,46 @@
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/strings.hpp>
+
+using namespace pasta;
+
+using Parts = std::vector<std::string>;
+
+TEST_CASE("split by delimiter", "[strings]")
+{
+    REQUIRE(split("ab cd", ' ') == Parts { "ab", "cd" });
+    REQUIRE(split("ab  cd", ' ') == Parts { "ab", "", "cd" });
+    REQUIRE(split("abcd", ' ') == Parts { "abcd" });
+    REQUIRE(split("", ',') == Parts { "" });
+    REQUIRE(split("a,b,", ',') == Parts { "a", "b", "" });
+    REQUIRE(split(",a", ',') == Parts { "", "a" });
+    REQUIRE(split(",,", ',') == Parts { "", "", "" });
+}
+
+TEST_CASE("split by whitespace", "[strings]")
+{
+    REQUIRE(split("ab  cd") == Parts { "ab", "cd" });
+    REQUIRE(split(" \tab\ncd ") == Parts { "ab", "cd" });
+    REQUIRE(split("") == Parts {});
+    REQUIRE(split("   ") == Parts {});
+}
+
+TEST_CASE("startsWith/endsWith", "[strings]")
+{
+    REQUIRE(startsWith("foobar", "foo"));
+    REQUIRE(!startsWith("foobar", "bar"));
+    REQUIRE(startsWith("foo", ""));
+    REQUIRE(!startsWith("foo", "foobar"));
+
+    REQUIRE(endsWith("foobar", "bar"));
+    REQUIRE(!endsWith("foobar", "foo"));
+    REQUIRE(endsWith("foo", ""));
+    REQUIRE(endsWith("foo", "foo"));
+    // The suffix is longer than the string
+    REQUIRE(!endsWith("bar", "foobar"));
+    REQUIRE(!endsWith("", "a"));
+}
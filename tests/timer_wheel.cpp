@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_ENABLE_ALL_STRINGMAKERS
+#include <catch2/catch_test_macros.hpp>
+
+#include <cppasta/timer_wheel.hpp>
+
+using namespace pasta;
+
+TEST_CASE("TimerWheel basics", "[timer_wheel]")
+{
+    TimerWheel<int> wheel(4);
+    std::vector<int> fired;
+    auto collect = [&](int v) { fired.push_back(v); };
+
+    const auto a = wheel.schedule(5, 1);
+    const auto b = wheel.schedule(5, 2);
+    const auto c = wheel.schedule(3, 3);
+    wheel.schedule(0, 4); // fires on the next tick
+    REQUIRE(wheel.size() == 4);
+
+    REQUIRE(wheel.advance(1, collect) == 1);
+    REQUIRE(fired == std::vector<int> { 4 });
+
+    REQUIRE(wheel.cancel(b));
+    REQUIRE(!wheel.cancel(b));
+    REQUIRE(wheel.reschedule(c, 10));
+    REQUIRE(wheel.expiry(c) == 11);
+
+    fired.clear();
+    wheel.advance(4, collect);
+    REQUIRE(wheel.now() == 5);
+    REQUIRE(fired == std::vector<int> { 1 });
+    REQUIRE(!wheel.cancel(a));
+    REQUIRE(!wheel.contains(a));
+
+    // Stale key, even if the slot is reused
+    const auto d = wheel.schedule(1, 5);
+    REQUIRE(!wheel.cancel(a));
+    REQUIRE(*wheel.find(d) == 5);
+
+    fired.clear();
+    wheel.advance_to(11, collect);
+    REQUIRE(fired == std::vector<int> { 5, 3 });
+    REQUIRE(wheel.size() == 0);
+}
+
+TEST_CASE("TimerWheel against reference", "[timer_wheel]")
+{
+    // Small wheel, so we get a lot of cascading and overflow
+    using Wheel = TimerWheel<uint32_t, CompositeId<uint32_t>, 2, 3>;
+    Wheel wheel;
+    std::map<uint32_t, uint64_t> ref; // id -> expiry
+    std::vector<Wheel::Key> keys;
+
+    std::mt19937 rng(42);
+    uint32_t next_id = 0;
+    for (size_t i = 0; i < 20'000; ++i) {
+        const auto op = rng() % 10;
+        if (op < 5) {
+            // Up to 4 times the range of the wheel (64 ticks)
+            const auto delay = rng() % 256;
+            keys.push_back(wheel.schedule(delay, next_id));
+            ref[next_id] = std::max(wheel.now() + delay, wheel.now() + 1);
+            next_id++;
+        } else if (op < 6 && !keys.empty()) {
+            const auto id = static_cast<uint32_t>(rng() % keys.size());
+            REQUIRE(wheel.cancel(keys[id]) == (ref.erase(id) > 0));
+        } else if (op < 7 && !keys.empty()) {
+            const auto id = static_cast<uint32_t>(rng() % keys.size());
+            const auto delay = rng() % 256;
+            const auto exists = ref.contains(id);
+            REQUIRE(wheel.reschedule(keys[id], delay) == exists);
+            if (exists) {
+                ref[id] = std::max(wheel.now() + delay, wheel.now() + 1);
+            }
+        } else {
+            const auto ticks = rng() % 8;
+            for (uint64_t t = 0; t < ticks; ++t) {
+                std::vector<uint32_t> fired;
+                wheel.advance(1, [&](uint32_t id) { fired.push_back(id); });
+                std::vector<uint32_t> expected;
+                for (const auto& [id, expiry] : ref) {
+                    if (expiry == wheel.now()) {
+                        expected.push_back(id);
+                    }
+                }
+                for (const auto id : expected) {
+                    ref.erase(id);
+                }
+                std::sort(fired.begin(), fired.end());
+                REQUIRE(fired == expected);
+            }
+        }
+        REQUIRE(wheel.size() == ref.size());
+    }
+}